@@ -0,0 +1,65 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/http/server.hpp>
+#include <g6/io/context.hpp>
+#include <g6/web/buffer.hpp>
+
+#include <unifex/scope_guard.hpp>
+#include <unifex/sync_wait.hpp>
+#include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
+
+#include <vector>
+
+using namespace g6;
+
+// Reports receive buffer memory held by idle kept-alive connections.
+// Note: file descriptors limit must be raised accordingly (ulimit -n).
+
+int main(int argc, char **argv) {
+    spdlog::set_level(spdlog::level::warn);
+
+    size_t connection_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    auto &pool = web::buffer_pool::local();
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    std::string body(32 * 1024, 'x');
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{body.data(), body.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            std::vector<net::async_socket> sockets;
+            sockets.reserve(connection_count);
+            std::string request = "POST / HTTP/1.1\r\nContent-Length: 16384\r\n\r\n" + std::string(16 * 1024, 'x');
+            std::array<char, 64 * 1024> buffer{};
+            for (size_t ii = 0; ii < connection_count; ++ii) {
+                auto &sock = sockets.emplace_back(net::open_socket(ctx, net::tcp_client));
+                co_await net::async_connect(sock, server_endpoint);
+                co_await net::async_send(sock, as_bytes(span{request.data(), request.size()}));
+                size_t received = 0;
+                while (received < 32 * 1024) {
+                    received += co_await net::async_recv(sock, as_writable_bytes(span{buffer}));
+                }
+            }
+            auto const &stats = pool.statistics();
+            spdlog::warn("{} idle connections: {} bytes in use ({} slabs), {} bytes pooled, {} bytes/connection "
+                         "(+ {} bytes of session)",
+                         connection_count, stats.in_use_bytes, stats.in_use_slabs, stats.pooled_bytes,
+                         stats.in_use_bytes / connection_count, sizeof(http::server_session<net::async_socket>));
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
@@ -0,0 +1,85 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/http/client.hpp>
+#include <g6/http/server.hpp>
+#include <g6/io/context.hpp>
+
+#include <unifex/scope_guard.hpp>
+#include <unifex/sync_wait.hpp>
+#include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
+
+#include <chrono>
+
+using namespace g6;
+
+// Small JSON responses and 1 KiB chunk streams (header, body and chunk framing are gathered in a single write).
+
+int main(int argc, char **argv) {
+    spdlog::set_level(spdlog::level::warn);
+
+    size_t request_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+    size_t chunk_count = argc > 2 ? std::stoul(argv[2]) : 100000;
+
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    server.options().max_requests_per_connection = 0;
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    static constexpr std::string_view json = R"({"id":42,"name":"g6","tags":["web","net"],"ok":true})";
+    static const std::string chunk(1024, 'c');
+
+    using clock = std::chrono::steady_clock;
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, chunk_count]<typename Request>(Request request) -> task<void> {
+                    if (request.url() == "/json") {
+                        http::headers headers{{"Content-Type", "application/json"}};
+                        co_await net::async_send(session, http::status::ok, std::move(headers),
+                                                 as_bytes(span{json.data(), json.size()}));
+                    } else {
+                        http::headers headers{{"Transfer-Encoding", "chunked"}};
+                        auto response = co_await net::async_send(session, http::status::ok, std::move(headers));
+                        for (size_t ii = 0; ii < chunk_count; ++ii) {
+                            co_await net::async_send(response, as_bytes(span{chunk.data(), chunk.size()}));
+                        }
+                        co_await net::async_send(response);
+                    }
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            {
+                auto start = clock::now();
+                for (size_t ii = 0; ii < request_count; ++ii) {
+                    auto response = co_await net::async_send(client, "/json", http::method::get);
+                    while (net::has_pending_data(response)) { co_await net::async_recv(response); }
+                }
+                auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+                spdlog::warn("small json: {} requests in {:.3f}s ({:.0f} req/s)", request_count, seconds,
+                             double(request_count) / seconds);
+            }
+            {
+                auto start = clock::now();
+                size_t received = 0;
+                auto response = co_await net::async_send(client, "/stream", http::method::get);
+                while (net::has_pending_data(response)) {
+                    auto body = co_await net::async_recv(response);
+                    received += body.size();
+                }
+                auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+                spdlog::warn("1 KiB chunks: {} chunks in {:.3f}s ({:.1f} MiB/s)", chunk_count, seconds,
+                             double(received) / seconds / (1024 * 1024));
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
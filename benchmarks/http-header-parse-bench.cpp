@@ -0,0 +1,69 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/http/http.hpp>
+#include <g6/http/impl/static_parser_handler.hpp>
+
+#include <chrono>
+#include <string_view>
+
+using namespace g6;
+
+// Parses a typical browser request (15 headers): zero-copy header views vs copies into http::headers.
+
+namespace {
+    constexpr std::string_view browser_request =
+        "GET /assets/app.js?v=42 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "Cache-Control: max-age=0\r\n"
+        "sec-ch-ua: \"Chromium\";v=\"118\", \"Google Chrome\";v=\"118\", \"Not=A?Brand\";v=\"99\"\r\n"
+        "sec-ch-ua-mobile: ?0\r\n"
+        "sec-ch-ua-platform: \"Linux\"\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+        "Chrome/118.0.0.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "Sec-Fetch-Mode: navigate\r\n"
+        "Sec-Fetch-Dest: document\r\n"
+        "Referer: https://www.example.com/index.html\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: en-US,en;q=0.9,fr;q=0.8\r\n"
+        "\r\n";
+
+    struct request_parser : http::detail::static_parser_handler<true> {};
+}// namespace
+
+int main(int argc, char **argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    using clock = std::chrono::steady_clock;
+    auto report = [iterations](std::string_view name, clock::duration elapsed) {
+        auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        spdlog::info("{}: {:.1f} ns/request", name, ns / double(iterations));
+    };
+
+    request_parser parser;
+    auto data = as_bytes(span{browser_request.data(), browser_request.size()});
+    size_t checksum = 0;
+    {
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) {
+            parser.parse(data);
+            checksum += parser.header("user-agent").size();
+        }
+        report("header views", clock::now() - start);
+    }
+    {
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) {
+            parser.parse(data);
+            // former storage: one multimap node and two strings per header
+            http::headers copy;
+            for (auto &[field, value] : parser.headers()) { copy.emplace(field, value); }
+            checksum += copy.find("User-Agent")->second.size();
+        }
+        report("header copies", clock::now() - start);
+    }
+    spdlog::debug("checksum: {}", checksum);
+}
@@ -0,0 +1,74 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/http/client.hpp>
+#include <g6/http/server.hpp>
+#include <g6/io/context.hpp>
+
+#include <unifex/scope_guard.hpp>
+#include <unifex/sync_wait.hpp>
+#include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
+
+#include <chrono>
+
+using namespace g6;
+
+// Compares request rate with a new connection per request vs a single kept-alive connection.
+
+namespace {
+    template<typename Client>
+    task<void> do_request(Client &client) {
+        auto response = co_await net::async_send(client, "/", http::method::get);
+        while (net::has_pending_data(response)) { co_await net::async_recv(response); }
+    }
+}// namespace
+
+int main(int argc, char **argv) {
+    spdlog::set_level(spdlog::level::warn);
+
+    size_t request_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    server.options().max_requests_per_connection = 0;
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    using clock = std::chrono::steady_clock;
+    auto report = [request_count](std::string_view name, clock::duration elapsed) {
+        auto seconds = std::chrono::duration<double>(elapsed).count();
+        spdlog::warn("{}: {} requests in {:.3f}s ({:.0f} req/s)", name, request_count, seconds,
+                     double(request_count) / seconds);
+    };
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{"OK !", 4}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            {
+                auto start = clock::now();
+                for (size_t ii = 0; ii < request_count; ++ii) {
+                    auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+                    co_await do_request(client);
+                }
+                report("connection per request", clock::now() - start);
+            }
+            {
+                auto start = clock::now();
+                auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+                for (size_t ii = 0; ii < request_count; ++ii) { co_await do_request(client); }
+                report("kept-alive connection", clock::now() - start);
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
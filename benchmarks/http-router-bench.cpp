@@ -0,0 +1,93 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/http/router.hpp>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace g6;
+
+// Routes 10/100/1000 "/resource<N>/(\d+)" patterns: per-method/first-segment dispatch
+// (http::route::router) vs trying each route regex in sequence (g6::router::router).
+
+namespace {
+    constexpr size_t digits(size_t value) noexcept {
+        size_t count = 1;
+        for (; value >= 10; value /= 10) { ++count; }
+        return count;
+    }
+
+    constexpr std::string_view pattern_prefix = "/resource";
+    constexpr std::string_view pattern_suffix = R"(/(\d+))";
+
+    template<size_t index>
+    struct route_pattern {
+        char data[pattern_prefix.size() + digits(index) + pattern_suffix.size() + 1]{};
+
+        constexpr route_pattern() noexcept {
+            size_t pos = 0;
+            for (char c : pattern_prefix) { data[pos++] = c; }
+            pos += digits(index);
+            for (size_t value = index, digit = pos; digit-- > pattern_prefix.size(); value /= 10) {
+                data[digit] = char('0' + value % 10);
+            }
+            for (char c : pattern_suffix) { data[pos++] = c; }
+        }
+    };
+
+    template<size_t index>
+    inline constexpr route_pattern<index> route_pattern_v{};
+
+    auto make_handler() {
+        return [](std::string_view id) { return id.size(); };
+    }
+
+    template<size_t index>
+    auto make_route() {
+        return http::route::get<ctll::fixed_string{route_pattern_v<index>.data}>(make_handler());
+    }
+
+    auto make_fallback() {
+        return router::on<R"(.*)">([] { return size_t{0}; });
+    }
+
+    template<size_t route_count>
+    void run(size_t iterations) {
+        using clock = std::chrono::steady_clock;
+        auto report = [iterations](std::string_view name, std::string_view path, clock::duration elapsed) {
+            auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+            spdlog::info("{} routes, {} ({}): {:.1f} ns/request", route_count, name, path, ns / double(iterations));
+        };
+
+        auto table_router = []<size_t... indices>(std::index_sequence<indices...>) {
+            return http::route::router{std::make_tuple(), make_route<indices>()..., make_fallback()};
+        }(std::make_index_sequence<route_count>{});
+        auto linear_router = []<size_t... indices>(std::index_sequence<indices...>) {
+            return router::router{std::make_tuple(), make_route<indices>()..., make_fallback()};
+        }(std::make_index_sequence<route_count>{});
+
+        const std::string first_route = "/resource0/42";
+        const std::string last_route = fmt::format("/resource{}/42", route_count - 1);
+        const std::string miss = "/unknown/42";
+        size_t checksum = 0;
+        for (std::string_view path : {std::string_view{first_route}, std::string_view{last_route},
+                                      std::string_view{miss}}) {
+            auto start = clock::now();
+            for (size_t ii = 0; ii < iterations; ++ii) { checksum += table_router(path, http::method::get); }
+            report("route table", path, clock::now() - start);
+            start = clock::now();
+            for (size_t ii = 0; ii < iterations; ++ii) { checksum += linear_router(path, http::method::get); }
+            report("linear", path, clock::now() - start);
+        }
+        spdlog::debug("checksum: {}", checksum);
+    }
+}// namespace
+
+int main(int argc, char **argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 100000;
+    run<10>(iterations);
+    run<100>(iterations);
+    run<1000>(iterations / 10);
+}
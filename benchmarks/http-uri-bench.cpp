@@ -0,0 +1,151 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/web/uri.hpp>
+
+#include <ctre.hpp>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+using namespace g6;
+
+// Splits a request target and reads two query parameters: lazy uri view vs the former
+// owning uri (input copy and full ctre match on construction).
+// Escapes/unescapes a long encoded search URL: vectorized kernels vs the former per-byte ctre match.
+
+namespace {
+    constexpr std::string_view target = "/api/v1/search?q=g6+web+server&page=3&lang=en&sort=relevance#results";
+
+    struct regex_uri {
+        static constexpr ctll::fixed_string regex =
+            R"(^(([^:/?#]+):)?(//(([^/:?#]*))(:([0-9]+))?)?([^?#]*)(\?([^#]*))?(#(.*))?)";
+
+        std::string uri_;
+        std::string_view path{};
+        std::string_view query{};
+
+        explicit regex_uri(std::string_view input) : uri_{input} {
+            if (auto m = ctre::match<regex>(uri_); m) {
+                path = m.get<8>();
+                query = m.get<10>();
+            }
+        }
+    };
+
+    const std::string search_target = [] {
+        std::string query;
+        for (int ii = 0; ii < 8; ++ii) { query += "\"caf\xc3\xa9 cr\xc3\xa8me\" AND (price<=20 OR tag:\"g6/web\") "; }
+        return "/api/v1/search?q=" + web::uri::escape(query) + "&lang=fr&page=1";
+    }();
+
+    std::string regex_escape(std::string_view input) {
+        std::string output{};
+        output.reserve(input.size());
+        for (size_t ii = 0; ii < input.size(); ++ii) {
+            static constexpr ctll::fixed_string printable_chars = R"([a-zA-Z0-9])";
+            if (not ctre::match<printable_chars>(std::string_view{&input[ii], 1})) {
+                output.append(fmt::format(FMT_STRING("%{:02X}"), uint8_t(input[ii])));
+            } else {
+                output.append(std::string_view{&input[ii], 1});
+            }
+        }
+        return output;
+    }
+
+    std::string regex_unescape(std::string_view input) {
+        std::string output{};
+        output.reserve(input.size());
+        for (size_t ii = 0; ii < input.size(); ++ii) {
+            static constexpr ctll::fixed_string two_printable_chars = R"(%[a-zA-Z0-9]{2})";
+            if (ii + 2 < input.size() and ctre::match<two_printable_chars>(std::string_view{&input[ii], 3})) {
+                uint8_t c{};
+                std::from_chars(&input[ii + 1], &input[ii + 3], c, 16);
+                output.push_back(char(c));
+                ii += 2;
+            } else {
+                output.push_back(input[ii]);
+            }
+        }
+        return output;
+    }
+
+    // former query access: the whole query string had to be split by the caller
+    std::string_view find_parameter(std::string_view query, std::string_view name) {
+        while (not query.empty()) {
+            auto item = query.substr(0, query.find('&'));
+            query.remove_prefix(std::min(item.size() + 1, query.size()));
+            if (item.starts_with(name) and item.size() > name.size() and item[name.size()] == '=') {
+                return item.substr(name.size() + 1);
+            }
+        }
+        return {};
+    }
+}// namespace
+
+int main(int argc, char **argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    using clock = std::chrono::steady_clock;
+    auto report = [iterations](std::string_view name, clock::duration elapsed) {
+        auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        spdlog::info("{}: {:.1f} ns/request", name, ns / double(iterations));
+    };
+
+    size_t checksum = 0;
+    {
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) {
+            web::uri uri{target};
+            checksum += uri.path().size() + *uri.get<int>("page") + uri.get("lang")->size();
+        }
+        report("uri view", clock::now() - start);
+    }
+    {
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) {
+            regex_uri uri{target};
+            int page = 0;
+            auto value = find_parameter(uri.query, "page");
+            std::from_chars(value.data(), value.data() + value.size(), page);
+            checksum += uri.path.size() + page + find_parameter(uri.query, "lang").size();
+        }
+        report("regex uri", clock::now() - start);
+    }
+    const auto decoded = web::uri::unescape(search_target);
+    spdlog::info("search url: {} bytes, {} decoded", search_target.size(), decoded.size());
+    {
+        std::string output;
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) {
+            output.clear();
+            web::uri::unescape(search_target, output);
+            checksum += output.size();
+        }
+        report("unescape", clock::now() - start);
+    }
+    {
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) { checksum += regex_unescape(search_target).size(); }
+        report("regex unescape", clock::now() - start);
+    }
+    {
+        std::string output;
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) {
+            output.clear();
+            web::uri::escape(decoded, output);
+            checksum += output.size();
+        }
+        report("escape", clock::now() - start);
+    }
+    {
+        auto start = clock::now();
+        for (size_t ii = 0; ii < iterations; ++ii) { checksum += regex_escape(decoded).size(); }
+        report("regex escape", clock::now() - start);
+    }
+    spdlog::debug("checksum: {}", checksum);
+}
@@ -0,0 +1,91 @@
+#include <spdlog/spdlog.h>
+
+#include <g6/ws/deflate.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace g6;
+
+// JSON feed (market data like updates) sent by a server: bytes on the wire and CPU time per message,
+// without compression and with permessage-deflate (context takeover or not, narrow windows, fast level).
+
+namespace {
+    std::vector<std::string> make_feed(size_t count) {
+        std::mt19937 generator{42};
+        std::uniform_int_distribution<int> symbol{0, 49}, quantity{1, 5000}, cents{100, 1000000};
+        std::vector<std::string> feed;
+        feed.reserve(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            std::string message = fmt::format(R"({{"type":"update","sequence":{},"updates":[)", ii);
+            for (int jj = 0; jj < 8; ++jj) {
+                message += fmt::format(
+                    R"({}{{"symbol":"SYM{:02}","bid":{:.2f},"ask":{:.2f},"quantity":{},"exchange":"XPAR"}})",
+                    jj == 0 ? "" : ",", symbol(generator), cents(generator) / 100.0, cents(generator) / 100.0,
+                    quantity(generator));
+            }
+            message += "]}";
+            feed.push_back(std::move(message));
+        }
+        return feed;
+    }
+
+    size_t frame_size(size_t payload_size) {
+        return payload_size + (payload_size < 126 ? 2 : payload_size <= 0xffff ? 4 : 10);
+    }
+}// namespace
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const auto feed = make_feed(count);
+
+    using clock = std::chrono::steady_clock;
+    size_t raw_bytes = 0;
+    for (auto const &message : feed) { raw_bytes += frame_size(message.size()); }
+    spdlog::info("{} messages, {:.0f} bytes/message on the wire without compression", count,
+                 double(raw_bytes) / double(count));
+
+    struct config {
+        std::string_view name;
+        ws::deflate_params params;
+        int level;
+    };
+    for (auto const &[name, params, level] : {
+             config{"context takeover", {}, Z_DEFAULT_COMPRESSION},
+             config{"no context takeover", {.server_no_context_takeover = true}, Z_DEFAULT_COMPRESSION},
+             config{"10 bits window", {.server_max_window_bits = 10, .client_max_window_bits = 10}, Z_DEFAULT_COMPRESSION},
+             config{"level 1", {}, 1},
+         }) {
+        ws::deflate_codec server{params, true, level};
+        ws::deflate_codec client{params, false, level};
+        size_t wire_bytes = 0;
+        size_t checksum = 0;
+        clock::duration compress_time{}, decompress_time{};
+        for (auto const &message : feed) {
+            auto start = clock::now();
+            auto payload = server.compress(as_bytes(unifex::span{message.data(), message.size()}));
+            std::vector<std::byte> frame{payload.begin(), payload.end()};
+            server.end_compress();
+            auto compressed = clock::now();
+            frame.insert(frame.end(), std::begin(ws::deflate_codec::tail), std::end(ws::deflate_codec::tail));
+            unifex::span<std::byte const> input{frame.data(), frame.size()};
+            while (not input.empty() or client.decompress_full()) { checksum += client.decompress(input, 16 * 1024).size(); }
+            client.end_decompress();
+            decompress_time += clock::now() - compressed;
+            compress_time += compressed - start;
+            wire_bytes += frame_size(payload.size());
+        }
+        auto per_message = [count](clock::duration elapsed) {
+            return std::chrono::duration<double, std::micro>(elapsed).count() / double(count);
+        };
+        spdlog::info("{}: {:.0f} bytes/message ({:.1f}x), compress {:.2f} us/message, decompress {:.2f} us/message",
+                     name, double(wire_bytes) / double(count), double(raw_bytes) / double(wire_bytes),
+                     per_message(compress_time), per_message(decompress_time));
+        spdlog::debug("checksum: {}", checksum);
+    }
+}
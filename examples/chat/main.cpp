@@ -4,6 +4,7 @@
 #include <g6/http/router.hpp>
 #include <g6/http/server.hpp>
 #include <g6/io/context.hpp>
+#include <g6/ws/hub.hpp>
 #include <g6/ws/server.hpp>
 
 #include <unifex/scope_guard.hpp>
@@ -39,7 +40,6 @@ namespace {
 }
 
 #include <csignal>
-#include <list>
 
 void terminate_handler(int) {
     g_stop_source.request_stop();
@@ -66,9 +66,10 @@ int main(int argc, char **argv) {
     spdlog::info("server listening at: http://{}", server_endpoint.to_string());
 
     async_scope scope{};
-    std::list<ws::server_session<net::async_socket> *> all_sessions{};
+    using chat_hub = ws::hub<ws::server_session<net::async_socket>>;
+    chat_hub hub{};
 
-    auto router = router::router{
+    auto router = http::route::router{
         std::make_tuple(),// global context
         http::route::get<R"(/)">([&](router::context<http::server_session<net::async_socket>> session,
                                      router::context<http::server_request<net::async_socket>> request) -> task<void> {
@@ -83,34 +84,33 @@ int main(int argc, char **argv) {
             auto ws_session = co_await web::upgrade_connection(web::proto::ws, *session, *request);
             spdlog::info("connection upgraded...");
             scope->spawn(
-                [](auto session, auto &all_sessions) -> task<void> {
-                    all_sessions.push_front(&session);
+                [](auto session, chat_hub &hub) -> task<void> {
+                    chat_hub::subscriber subscriber{hub, session};
+                    subscriber.join("chat");
                     spdlog::info("websocket connection started...");
-                    while (true) try {
-                            auto message = co_await net::async_recv(session);
-                            while (net::has_pending_data(message)) {
-                                auto data = co_await net::async_recv(message);
-                                spdlog::info("data from {}: {}", session.remote_endpoint().to_string(),
-                                             as_string_view(data));
-                                spdlog::info("{} other connections", std::size(all_sessions) - 1);
-                                for (auto other_session : all_sessions) {
-                                    if (*other_session != session) {
-                                        spdlog::info("sending data to: {}",
-                                                     other_session->remote_endpoint().to_string());
-                                        co_await net::async_send(*other_session, data);
-                                    }
+                    co_await when_all(subscriber.async_run(), [&]() -> task<void> {
+                        scope_guard _ = [&]() noexcept { subscriber.close(); };
+                        while (true) try {
+                                auto message = co_await net::async_recv(session);
+                                std::string text;
+                                while (net::has_pending_data(message)) {
+                                    text += as_string_view(co_await net::async_recv(message));
                                 }
+                                spdlog::info("data from {}: {}", session.remote_endpoint().to_string(), text);
+                                auto receivers =
+                                    hub.publish("chat", as_bytes(span{text.data(), text.size()}), &subscriber);
+                                spdlog::info("sent to {} other connections", receivers);
+                            } catch (std::system_error const &error) {
+                                if (error.code() != std::errc::connection_reset) {
+                                    spdlog::error("error on {}: {}", session.remote_endpoint().to_string(),
+                                                  error.what());
+                                }
+                                spdlog::error("connection reset: {}", session.remote_endpoint().to_string());
+                                break;
                             }
-                        } catch (std::system_error const &error) {
-                            if (error.code() != std::errc::connection_reset) {
-                                spdlog::error("error on {}: {}", session.remote_endpoint().to_string(), error.what());
-                            }
-                            spdlog::error("connection reset: {}", session.remote_endpoint().to_string());
-                            break;
-                        }
-                    std::erase_if(all_sessions, [&](auto const &other) { return other == &session; });
-                    spdlog::info("{} remaining connections", std::size(all_sessions));
-                }(std::move(ws_session), all_sessions),
+                    }());
+                    spdlog::info("{} remaining connections", hub.size() - 1);
+                }(std::move(ws_session), hub),
                 context.get_scheduler());
             throw std::system_error{std::make_error_code(std::errc::connection_reset)};
         }),
@@ -126,8 +126,7 @@ int main(int argc, char **argv) {
             co_await web::async_serve(server, g_stop_source, [&]<typename Session>(Session &session) {
                 return [root_path, &session, &router,
                         &scope = scope]<typename Request>(Request request) mutable -> task<void> {
-                    co_await router(request.url(), request.method(), std::ref(session), std::ref(request),
-                                    std::ref(scope));
+                    co_await router.async_serve(session, request, std::ref(scope));
                     while (net::has_pending_data(request)) {
                         co_await net::async_recv(request);// flush unused body
                     }
@@ -1,7 +1,9 @@
 #include <spdlog/spdlog.h>
 
 #include <g6/http/client.hpp>
+#include <g6/http/content_encoding.hpp>
 #include <g6/http/router.hpp>
+#include <g6/http/response_cache.hpp>
 #include <g6/http/server.hpp>
 #include <g6/io/context.hpp>
 
@@ -94,9 +96,10 @@ int main(int argc, char **argv) {
     auto server = web::make_server(context, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
     auto server_endpoint = *server.socket.local_endpoint();
     fs::path root_path = ".";
+    http::response_cache cache{};
     spdlog::info("server listening at: http://{}", server_endpoint.to_string());
 
-    auto router = router::router{
+    auto router = http::route::router{
         std::make_tuple(),// global context
         http::route::get<R"(/(.*))">(
             [&](std::string_view path, router::context<http::server_session<net::async_socket>> session,
@@ -116,20 +119,12 @@ int main(int argc, char **argv) {
                         list_dir_template_, fmt::arg("title", path),
                         fmt::arg("body", std::string_view{body.data(), body.size()}), fmt::arg("path", path),
                         fmt::arg("breadcrumb", std::string_view{breadcrumb.data(), breadcrumb.size()}));
-                    co_await net::async_send(*session, http::status::ok, as_bytes(span{page.data(), page.size()}));
+                    http::headers headers{{"Content-Type", "text/html; charset=utf-8"}};
+                    co_await http::async_send_encoded(*session, *request, http::status::ok, std::move(headers),
+                                                      as_bytes(span{page.data(), page.size()}));
                 } else {
                     try {
-                        auto file = open_file_read_only(context.get_scheduler(), root_path / path);
-                        http::headers headers{{"Transfer-Encoding", "chunked"}};
-                        auto stream = co_await net::async_send(*session, http::status::ok, std::move(headers));
-                        std::array<char, 1024> data{};
-                        size_t offset = 0;
-                        while (size_t bytes =
-                                   co_await async_read_some_at(file, offset, as_writable_bytes(span{data}))) {
-                            offset += bytes;
-                            co_await net::async_send(stream, as_bytes(span{data.data(), bytes}));
-                        }
-                        co_await net::async_send(stream);// close stream
+                        co_await http::async_send_cached_file(cache, *session, *request, root_path / path);
                     } catch (std::system_error &error) {
                         auto err_page = fmt::format(R"(<div><h6>Not found</h6><p>{}</p></div>)", error.what());
                         co_await net::async_send(*session, http::status::not_found,
@@ -149,7 +144,7 @@ int main(int argc, char **argv) {
         [&]() -> task<void> {
             co_await web::async_serve(server, g_stop_source, [&]<typename Session>(Session &session) {
                 return [root_path, &session, &router]<typename Request>(Request request) mutable -> task<void> {
-                    co_await router(request.url(), request.method(), std::ref(request), std::ref(session));
+                    co_await router.async_serve(session, request);
                     while (net::has_pending_data(request)) {
                         co_await net::async_recv(request);// flush unused body
                     }
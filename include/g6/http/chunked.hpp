@@ -0,0 +1,39 @@
+#pragma once
+
+#include <g6/net/net_cpo.hpp>
+#include <g6/web/gather.hpp>
+
+#include <unifex/span.hpp>
+#include <unifex/task.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <string_view>
+
+namespace g6::http::detail {
+
+    /** @brief Send a chunk of a chunked body (Transfer-Encoding: chunked).
+     *
+     * Chunk size line, data and CRLF are gathered in a single write.
+     * Empty @a data is not sent (an empty chunk terminates the body).
+     */
+    template<typename Socket>
+    task<size_t> async_send_chunk(Socket &socket, span<std::byte const> data) {
+        if (data.empty()) { co_return 0; }
+        std::array<char, 20> size_line{};
+        auto end = fmt::format_to_n(size_line.data(), size_line.size(), "{:x}\r\n", data.size()).out;
+        co_await web::async_gather_send(socket, as_bytes(span{size_line.data(), size_t(end - size_line.data())}), data,
+                                        as_bytes(span{"\r\n", 2}));
+        co_return data.size();
+    }
+
+    /** @brief Send the last (empty) chunk, without trailers.
+     */
+    template<typename Socket>
+    auto async_send_last_chunk(Socket &socket) {
+        static constexpr std::string_view last_chunk = "0\r\n\r\n";
+        return net::async_send(socket, as_bytes(span{last_chunk.data(), last_chunk.size()}));
+    }
+
+}// namespace g6::http::detail
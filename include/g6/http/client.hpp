@@ -1,5 +1,6 @@
 #pragma once
 
+#include <g6/http/chunked.hpp>
 #include <g6/http/http.hpp>
 #include <g6/http/impl/static_parser_handler.hpp>
 
@@ -8,57 +9,192 @@
 
 #include <g6/ssl/async_socket.hpp>
 
+#include <g6/web/buffer.hpp>
+#include <g6/web/gather.hpp>
 #include <g6/web/proto.hpp>
 
 #include <g6/web/web_cpo.hpp>
 #include <unifex/any_sender_of.hpp>
+#include <unifex/async_manual_reset_event.hpp>
+#include <unifex/async_mutex.hpp>
 #include <unifex/just.hpp>
 #include <unifex/let_with.hpp>
+#include <unifex/scope_guard.hpp>
 #include <unifex/sequence.hpp>
 #include <unifex/transform.hpp>
 
+#include <map>
+#include <memory>
+
 namespace g6::http {
 
+    namespace detail {
+        /** @brief Connection state shared by the (pipelined) requests of a client.
+         *
+         * Requests are written one at a time (send_mutex), responses are parsed in request order
+         * from the shared receive buffer: a response waits for the previous ones to be completely received.
+         */
+        struct client_connection {
+            web::receive_buffer buffer{};
+            // received bytes not consumed by a response parser yet (might belong to next responses)
+            span<std::byte const> pending{};
+            // number of requests sent, and of responses completely received
+            size_t sent = 0;
+            size_t received = 0;
+            bool keep_alive = true;
+            // a response has been dropped before completion: next ones cannot be parsed
+            bool broken = false;
+            async_mutex send_mutex{};
+            // responses waiting for their turn, by request index
+            std::map<size_t, async_manual_reset_event *> turns{};
+
+            task<void> async_wait_turn(size_t index) {
+                async_manual_reset_event turn{};
+                turns.emplace(index, &turn);
+                scope_guard erase = [&]() noexcept { turns.erase(index); };
+                while (index != received and not broken) {
+                    co_await turn.async_wait();
+                    turn.reset();
+                }
+            }
+
+            void complete(bool keep) noexcept {
+                keep_alive = keep_alive and keep;
+                ++received;
+                if (auto it = turns.find(received); it != turns.end()) { it->second->set(); }
+            }
+
+            void abandon() noexcept {
+                broken = true;
+                for (auto &[index, turn] : turns) { turn->set(); }
+            }
+        };
+    }// namespace detail
+
     template<typename Context, typename Socket>
     class client
     {
-        using client_buffer = std::array<std::byte, 1024>;
-
     public:
         Socket socket;
 
+        /** @brief Response to a request sent by the client.
+         *
+         * Pipelined responses can be awaited concurrently, they are received in request order.
+         * A response dropped before being completely received fails the next ones (connection_reset).
+         */
         struct response : detail::static_parser_handler<false> {
             Socket &socket_;
-            span<std::byte> buffer_;
-            response(Socket &socket, span<std::byte> &buffer) noexcept : socket_{socket}, buffer_{buffer} {}
+            detail::client_connection *connection_;
+            // request index on the connection
+            size_t index_;
+            bool complete_{false};
+
+            response(Socket &socket, detail::client_connection &connection, size_t index, bool head) noexcept
+                : socket_{socket}, connection_{&connection}, index_{index} {
+                // HEAD responses have no body, whatever their Content-Length
+                skip_body(head);
+            }
 
-            response(response &&other) noexcept : socket_{other.socket_}, buffer_{other.buffer_} {};
+            response(response &&other) noexcept
+                : detail::static_parser_handler<false>{std::move(other)}, socket_{other.socket_},
+                  connection_{std::exchange(other.connection_, nullptr)}, index_{other.index_},
+                  complete_{other.complete_} {};
 
             response(response const &other) = delete;
 
+            ~response() noexcept {
+                if (connection_ and not complete_) { connection_->abandon(); }
+            }
+
             friend task<unifex::span<std::byte>> tag_invoke(unifex::tag_t<net::async_recv>, response &response) {
                 using namespace unifex;
-                if (response.has_body()) {
-                    co_return response.body();
-                } else {
-                    size_t bytes = co_await net::async_recv(response.socket_, as_writable_bytes(response.buffer_));
-                    if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
-                    response.parse(as_bytes(span{response.buffer_.data(), bytes}));
-                    co_return response.body();
+                auto &connection = *response.connection_;
+                if (response.index_ != connection.received) { co_await connection.async_wait_turn(response.index_); }
+                if (connection.broken) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
+                while (not response.has_body() and net::has_pending_data(response)) {
+                    if (connection.pending.empty()) {
+                        response.detach_headers();
+                        auto buffer = connection.buffer.prepare();
+                        size_t bytes = co_await net::async_recv(response.socket_, buffer);
+                        if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
+                        connection.buffer.commit(bytes);
+                        connection.pending = as_bytes(buffer.first(bytes));
+                    }
+                    connection.pending = connection.pending.subspan(response.parse(connection.pending));
+                }
+                auto body = response.body();
+                if (not net::has_pending_data(response)) {
+                    // client buffer is reused for next responses
+                    response.detach_headers();
+                    response.complete_ = true;
+                    // next response can be parsed (last body part is always empty)
+                    connection.complete(response.keep_alive());
+                }
+                co_return body;
+            }
+        };
+
+        /** @brief Chunked request body writer (see net::async_send(client, path, method, headers, http::chunked)).
+         *
+         * Closing the request (net::async_send without data) sends the last chunk and gives the response.
+         * Other requests are queued until the chunked request is closed.
+         */
+        struct request_stream {
+            Socket &socket_;
+            detail::client_connection *connection_;
+            size_t index_;
+            bool closed_{false};
+
+            request_stream(Socket &socket, detail::client_connection &connection, size_t index) noexcept
+                : socket_{socket}, connection_{&connection}, index_{index} {}
+
+            request_stream(request_stream &&other) noexcept
+                : socket_{other.socket_}, connection_{std::exchange(other.connection_, nullptr)},
+                  index_{other.index_}, closed_{other.closed_} {}
+            request_stream(request_stream const &) = delete;
+
+            ~request_stream() noexcept {
+                if (connection_ and not closed_) {
+                    // request body is incomplete
+                    connection_->abandon();
+                    connection_->send_mutex.unlock();
                 }
             }
+
+            template<typename T, size_t extent = unifex::dynamic_extent>
+            friend task<size_t> tag_invoke(unifex::tag_t<net::async_send>, request_stream &stream,
+                                           span<T, extent> data) {
+                assert(!stream.closed_);
+                return detail::async_send_chunk(stream.socket_, as_bytes(span{data.data(), data.size()}));
+            }
+
+            friend task<response> tag_invoke(unifex::tag_t<net::async_send>, request_stream &stream) {
+                assert(!stream.closed_);
+                co_await detail::async_send_last_chunk(stream.socket_);
+                stream.closed_ = true;
+                stream.connection_->send_mutex.unlock();
+                co_return response{stream.socket_, *stream.connection_, stream.index_, false};
+            }
         };
 
         auto const &remote_endpoint() const noexcept { return remote_endpoint_; }
 
+        /** @brief Connection reusability for a next request.
+         *
+         * @return false while responses are not completely received, or when the server closes the connection.
+         */
+        [[nodiscard]] bool reusable() const noexcept {
+            return connection_->sent == connection_->received and connection_->keep_alive and not connection_->broken;
+        }
+
         client(Context &context, Socket &&socket, net::ip_endpoint const &remote_endpoint)
             : context_{context}, socket{std::forward<Socket>(socket)}, remote_endpoint_{remote_endpoint} {}
 
     protected:
         Context &context_;
         net::ip_endpoint remote_endpoint_;
-        client_buffer buffer_data_{};
-        span<std::byte> buffer_{buffer_data_.data(), buffer_data_.size()};
+        // heap allocated: referenced by responses
+        std::unique_ptr<detail::client_connection> connection_ = std::make_unique<detail::client_connection>();
         std::string header_data_;
 
         friend auto &tag_invoke(unifex::tag_t<web::get_context>, client &client) { return client.context_; }
@@ -73,14 +209,46 @@ namespace g6::http {
             header_data_ += "\r\n";
         }
 
+        // writes a request (once previous requests are written), returns its index
+        task<size_t> async_send_request(std::string_view path, http::method method, http::headers &&hdrs,
+                                        span<std::byte const> data, bool keep_locked = false) {
+            auto &connection = *connection_;
+            co_await connection.send_mutex.async_lock();
+            bool sent = false;
+            scope_guard unlock = [&]() noexcept {
+                // a partially written request breaks the connection
+                if (not sent) { connection.abandon(); }
+                if (not sent or not keep_locked) { connection.send_mutex.unlock(); }
+            };
+            build_header(path, method, std::move(hdrs));
+            const size_t index = connection.sent++;
+            co_await web::async_gather_send(socket, as_bytes(span{header_data_.data(), header_data_.size()}), data);
+            sent = true;
+            co_return index;
+        }
+
+        /** @brief Send a request.
+         *
+         * Requests can be sent without waiting for the previous responses (pipelining):
+         * responses are received in request order.
+         */
         friend task<response> tag_invoke(unifex::tag_t<net::async_send>, client &client, std::string_view path,
                                          http::method method, span<std::byte const> data, http::headers hdrs) {
             if (data.size()) { hdrs.template emplace("Content-Length", std::to_string(data.size())); }
-            client.build_header(path, method, std::move(hdrs));
-            co_await net::async_send(
-                client.socket, unifex::as_bytes(unifex::span{client.header_data_.data(), client.header_data_.size()}));
-            co_await net::async_send(client.socket, data);
-            co_return response{client.socket, client.buffer_};
+            size_t index = co_await client.async_send_request(path, method, std::move(hdrs), data);
+            co_return response{client.socket, *client.connection_, index, method == http::method::head};
+        }
+
+        /** @brief Send request headers for a chunked body (Transfer-Encoding: chunked).
+         *
+         * @return The body writer.
+         */
+        friend task<request_stream> tag_invoke(unifex::tag_t<net::async_send>, client &client, std::string_view path,
+                                               http::method method, http::headers &&hdrs, http::chunked_t) {
+            hdrs.erase("Content-Length");
+            if (not hdrs.contains("Transfer-Encoding")) { hdrs.emplace("Transfer-Encoding", "chunked"); }
+            size_t index = co_await client.async_send_request(path, method, std::move(hdrs), {}, true);
+            co_return request_stream{client.socket, *client.connection_, index};
         }
 
         friend auto tag_invoke(unifex::tag_t<net::async_send>, client &client, std::string_view path,
@@ -102,8 +270,8 @@ namespace g6::http {
 
     public:
         client(client &&other) noexcept
-            : context_{other.context_}, socket{std::move(other.socket)}, remote_endpoint_{
-                                                                             std::move(other.remote_endpoint_)} {}
+            : context_{other.context_}, socket{std::move(other.socket)},
+              remote_endpoint_{std::move(other.remote_endpoint_)}, connection_{std::move(other.connection_)} {}
         client(client const &other) = delete;
     };
 
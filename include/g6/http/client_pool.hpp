@@ -0,0 +1,275 @@
+#pragma once
+
+#include <g6/http/client.hpp>
+
+#include <g6/net/async_socket.hpp>
+#include <g6/net/ip_endpoint.hpp>
+#include <g6/ssl/async_socket.hpp>
+#include <g6/web/proto.hpp>
+
+#include <unifex/async_manual_reset_event.hpp>
+#include <unifex/scope_guard.hpp>
+#include <unifex/task.hpp>
+
+#include <sys/socket.h>
+
+#include <chrono>
+#include <deque>
+#include <list>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace g6::http {
+
+    struct client_pool_options {
+        // maximum number of connections (idle or in use) to a single host (0 means unlimited),
+        // further checkouts wait for a connection to be released
+        size_t max_per_host = 16;
+        // maximum number of idle connections kept per host
+        size_t max_idle_per_host = 8;
+        // idle connections older than this are closed instead of being reused
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds{30};
+        // https peer verification
+        ssl::verify_flags verify_flags{};
+    };
+
+    inline const client_pool_options default_client_pool_options{};
+
+    struct client_pool_stats {
+        // new connections
+        size_t connects = 0;
+        // checkouts served with an idle connection
+        size_t reuses = 0;
+        // idle connections closed (expired, closed by the server or over max_idle_per_host)
+        size_t discards = 0;
+    };
+
+    namespace detail {
+        // idle connection health: not closed by the peer and no unexpected data
+        template<typename Socket>
+        bool connection_alive(Socket &socket) noexcept {
+            if constexpr (requires { socket.native_handle(); }) {
+                std::byte probe{};
+                ssize_t bytes = ::recv(socket.native_handle(), &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+                return bytes < 0 and (errno == EAGAIN or errno == EWOULDBLOCK);
+            } else {
+                return true;
+            }
+        }
+
+        template<typename Client>
+        class host_pool
+        {
+        public:
+            using clock = std::chrono::steady_clock;
+
+            host_pool(client_pool_options const &options, client_pool_stats &stats) noexcept
+                : options_{&options}, stats_{&stats} {}
+
+            host_pool(host_pool const &) = delete;
+
+            // healthy idle connection (most recently used first)
+            std::optional<Client> take_idle() noexcept {
+                auto now = clock::now();
+                while (not idle_.empty()) {
+                    auto entry = std::move(idle_.back());
+                    idle_.pop_back();
+                    if (now - entry.since < options_->idle_timeout and connection_alive(entry.client->socket)) {
+                        ++stats_->reuses;
+                        return std::move(entry.client);
+                    }
+                    --connections_;
+                    ++stats_->discards;
+                }
+                return {};
+            }
+
+            // reserves a connection slot when max_per_host is not reached
+            bool try_reserve() noexcept {
+                if (options_->max_per_host != 0 and connections_ >= options_->max_per_host) { return false; }
+                ++connections_;
+                return true;
+            }
+
+            void cancel_reservation() noexcept { --connections_; }
+
+            /** @brief Wait for a released connection (or a free slot).
+             *
+             * @return The released connection, nullopt when a connection has been closed
+             *         (its slot is handed over).
+             */
+            task<std::optional<Client>> async_wait() {
+                waiter w{};
+                auto it = waiters_.insert(waiters_.end(), &w);
+                scope_guard remove = [&]() noexcept {
+                    if (not w.notified) {
+                        waiters_.erase(it);
+                    } else if (w.client) {
+                        // stopped after being notified: hand the connection over
+                        release(std::move(w.client));
+                    } else if (not w.consumed) {
+                        --connections_;
+                    }
+                };
+                co_await w.ready.async_wait();
+                w.consumed = true;
+                co_return std::exchange(w.client, std::nullopt);
+            }
+
+            void release(std::optional<Client> client) noexcept {
+                if (not client->reusable()) {
+                    client.reset();
+                    if (waiters_.empty()) { --connections_; }
+                } else if (waiters_.empty()) {
+                    if (idle_.size() < options_->max_idle_per_host) {
+                        try {
+                            idle_.push_back({std::move(client), clock::now()});
+                            return;
+                        } catch (...) {}
+                    }
+                    ++stats_->discards;
+                    --connections_;
+                    return;
+                }
+                if (not waiters_.empty()) {
+                    auto *w = waiters_.front();
+                    waiters_.pop_front();
+                    if (client) { w->client.emplace(std::move(*client)); }
+                    w->notified = true;
+                    w->ready.set();
+                }
+            }
+
+        private:
+            struct idle_client {
+                std::optional<Client> client;
+                clock::time_point since;
+            };
+
+            struct waiter {
+                async_manual_reset_event ready{};
+                std::optional<Client> client{};
+                bool notified{false};
+                bool consumed{false};
+            };
+
+            client_pool_options const *options_;
+            client_pool_stats *stats_;
+            // idle and checked-out connections
+            size_t connections_{0};
+            std::deque<idle_client> idle_;
+            std::list<waiter *> waiters_;
+        };
+    }// namespace detail
+
+    /** @brief Connection checked out from a client_pool.
+     *
+     * The connection goes back to the pool on destruction when it is reusable (last response completely
+     * received with keep-alive), it is closed otherwise.
+     */
+    template<typename Client>
+    class pooled_client
+    {
+    public:
+        pooled_client(detail::host_pool<Client> &host, Client &&client) noexcept
+            : host_{&host}, client_{std::move(client)} {}
+
+        pooled_client(pooled_client &&other) noexcept
+            : host_{std::exchange(other.host_, nullptr)}, client_{std::move(other.client_)} {}
+        pooled_client(pooled_client const &) = delete;
+
+        ~pooled_client() noexcept {
+            if (host_ and client_) { host_->release(std::move(client_)); }
+        }
+
+        Client &operator*() noexcept { return *client_; }
+        Client *operator->() noexcept { return &*client_; }
+
+    private:
+        detail::host_pool<Client> *host_;
+        std::optional<Client> client_;
+    };
+
+    /** @brief Keep-alive HTTP(S) connections, per remote endpoint and protocol.
+     *
+     * Idle connections are checked (idle timeout, closed by the server) on checkout, so that requests
+     * are not sent over dead connections. Reusing https connections saves the TLS handshake.
+     * The pool is not thread-safe: use one pool per io context.
+     *
+     * @code
+     * http::client_pool pool{context};
+     * auto client = co_await net::async_connect(pool, web::proto::http, endpoint);
+     * auto response = co_await net::async_send(*client, "/", http::method::get);
+     * @endcode
+     */
+    template<typename Context>
+    class client_pool
+    {
+    public:
+        using http_client = http::client<Context, net::async_socket>;
+        using https_client = http::client<Context, ssl::async_socket>;
+
+        explicit client_pool(Context &context, client_pool_options const &options = default_client_pool_options)
+            : context_{context}, options_{options} {}
+
+        client_pool(client_pool const &) = delete;
+
+        [[nodiscard]] client_pool_stats const &statistics() const noexcept { return stats_; }
+
+        friend task<pooled_client<http_client>> tag_invoke(unifex::tag_t<net::async_connect>, client_pool &pool,
+                                                           web::proto::http_ const &,
+                                                           net::ip_endpoint const &endpoint) {
+            return pool.async_checkout(pool.http_hosts_, endpoint, [&pool, endpoint] {
+                return net::async_connect(pool.context_, web::proto::http, endpoint);
+            });
+        }
+
+        friend task<pooled_client<https_client>> tag_invoke(unifex::tag_t<net::async_connect>, client_pool &pool,
+                                                            web::proto::https_ const &,
+                                                            net::ip_endpoint const &endpoint) {
+            return pool.async_checkout(pool.https_hosts_, endpoint, [&pool, endpoint] {
+                return net::async_connect(pool.context_, web::proto::https, endpoint, pool.options_.verify_flags);
+            });
+        }
+
+    private:
+        template<typename Client>
+        using host_map = std::map<std::string, detail::host_pool<Client>, std::less<>>;
+
+        template<typename Client, typename Connect>
+        task<pooled_client<Client>> async_checkout(host_map<Client> &hosts, net::ip_endpoint const &endpoint,
+                                                   Connect connect) {
+            auto key = endpoint.to_string();
+            auto it = hosts.find(key);
+            if (it == hosts.end()) { it = hosts.try_emplace(std::move(key), options_, stats_).first; }
+            auto &host = it->second;
+            while (true) {
+                if (auto client = host.take_idle()) { co_return pooled_client<Client>{host, std::move(*client)}; }
+                if (host.try_reserve()) {
+                    bool connected = false;
+                    scope_guard cancel = [&]() noexcept {
+                        if (not connected) { host.cancel_reservation(); }
+                    };
+                    auto client = co_await connect();
+                    connected = true;
+                    ++stats_.connects;
+                    co_return pooled_client<Client>{host, std::move(client)};
+                }
+                if (auto client = co_await host.async_wait()) {
+                    ++stats_.reuses;
+                    co_return pooled_client<Client>{host, std::move(*client)};
+                }
+                // a connection has been closed: its slot has been handed over
+                host.cancel_reservation();
+            }
+        }
+
+        Context &context_;
+        client_pool_options options_;
+        client_pool_stats stats_{};
+        host_map<http_client> http_hosts_;
+        host_map<https_client> https_hosts_;
+    };
+
+}// namespace g6::http
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <g6/http/file_body.hpp>
+#include <g6/http/header_map.hpp>
+#include <g6/http/http.hpp>
+#include <g6/http/session.hpp>
+
+#include <g6/web/deflate.hpp>
+
+#include <unifex/span.hpp>
+#include <unifex/task.hpp>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace g6::http {
+
+    enum class content_coding
+    {
+        identity,
+        gzip,
+        deflate,
+        br,
+    };
+
+    constexpr std::string_view to_string(content_coding coding) noexcept {
+        switch (coding) {
+            case content_coding::gzip:
+                return "gzip";
+            case content_coding::deflate:
+                return "deflate";
+            case content_coding::br:
+                return "br";
+            default:
+                return "identity";
+        }
+    }
+
+    /** @brief File name suffix of precompressed representations (empty when not supported).
+     */
+    constexpr std::string_view file_extension(content_coding coding) noexcept {
+        switch (coding) {
+            case content_coding::gzip:
+                return ".gz";
+            case content_coding::br:
+                return ".br";
+            default:
+                return {};
+        }
+    }
+
+    /** @brief Quality value (in thousandths) given to @a coding by an Accept-Encoding header value.
+     *
+     * @return 0 when @a coding is not acceptable.
+     */
+    constexpr int accept_quality(std::string_view accept_encoding, content_coding coding) noexcept {
+        auto trim = [](std::string_view str) {
+            str.remove_prefix(std::min(str.find_first_not_of(" \t"), str.size()));
+            str.remove_suffix(str.size() - std::min(str.find_last_not_of(" \t") + 1, str.size()));
+            return str;
+        };
+        // q=1, q=0.5, q=0.125
+        auto parse_quality = [](std::string_view value) {
+            if (value.empty() or value[0] < '0' or value[0] > '1') { return 0; }
+            int quality = (value[0] - '0') * 1000;
+            if (value.size() > 2 and value[1] == '.') {
+                int scale = 100;
+                for (char c : value.substr(2, 3)) {
+                    if (c < '0' or c > '9') { break; }
+                    quality += (c - '0') * scale;
+                    scale /= 10;
+                }
+            }
+            return std::min(quality, 1000);
+        };
+        std::optional<int> explicit_quality;
+        std::optional<int> any_quality;
+        while (not accept_encoding.empty()) {
+            auto separator = accept_encoding.find(',');
+            auto item = accept_encoding.substr(0, separator);
+            accept_encoding = separator == std::string_view::npos ? std::string_view{}
+                                                                  : accept_encoding.substr(separator + 1);
+            auto parameters = item.find(';');
+            auto name = trim(item.substr(0, parameters));
+            int quality = 1000;
+            if (parameters != std::string_view::npos) {
+                auto parameter = trim(item.substr(parameters + 1));
+                if (parameter.size() > 2 and detail::to_lower(parameter[0]) == 'q' and parameter[1] == '=') {
+                    quality = parse_quality(parameter.substr(2));
+                }
+            }
+            if (name == "*") {
+                any_quality = quality;
+            } else if (detail::iequals(name, to_string(coding))
+                       or (coding == content_coding::gzip and detail::iequals(name, "x-gzip"))) {
+                explicit_quality = quality;
+            }
+        }
+        if (explicit_quality) { return *explicit_quality; }
+        if (any_quality) { return *any_quality; }
+        // identity is acceptable unless explicitly excluded
+        return coding == content_coding::identity ? 1 : 0;
+    }
+
+    static_assert(accept_quality("gzip, deflate, br", content_coding::gzip) == 1000);
+    static_assert(accept_quality("br;q=0.8, gzip;q=0.25", content_coding::gzip) == 250);
+    static_assert(accept_quality("br;q=0, *", content_coding::br) == 0);
+    static_assert(accept_quality("deflate", content_coding::gzip) == 0);
+
+    /** @brief Select the preferred coding of @a available (in server preference order) for @a accept_encoding.
+     *
+     * @return identity when no coding of @a available is acceptable.
+     */
+    constexpr content_coding negotiate_encoding(std::string_view accept_encoding,
+                                                std::initializer_list<content_coding> available) noexcept {
+        content_coding selected = content_coding::identity;
+        int best = 0;
+        for (auto coding : available) {
+            if (int quality = accept_quality(accept_encoding, coding); quality > best) {
+                best = quality;
+                selected = coding;
+            }
+        }
+        return selected;
+    }
+
+    static_assert(negotiate_encoding("deflate, gzip;q=0.5", {content_coding::gzip, content_coding::deflate})
+                  == content_coding::deflate);
+    static_assert(negotiate_encoding("", {content_coding::gzip}) == content_coding::identity);
+
+    /** @brief Media types worth compressing (text, JSON, XML, JavaScript, SVG).
+     */
+    constexpr bool is_compressible(std::string_view content_type) noexcept {
+        content_type = content_type.substr(0, content_type.find(';'));
+        return content_type.empty() or content_type.starts_with("text/") or content_type.ends_with("json")
+            or content_type.ends_with("xml") or content_type.ends_with("javascript")
+            or content_type == "image/svg+xml" or content_type == "application/wasm";
+    }
+
+    struct compression_options {
+        // zlib compression level (1: fastest, 9: smallest)
+        int level = 6;
+        // smaller bodies are sent uncompressed
+        size_t min_size = 1024;
+    };
+
+    inline const compression_options default_compression_options{};
+
+    namespace detail {
+        // precompressed codings acceptable for @a accept_encoding, by preference (identity terminated)
+        constexpr std::array<content_coding, 2> precompressed_codings(std::string_view accept_encoding) noexcept {
+            std::array codings{content_coding::br, content_coding::gzip};
+            if (accept_quality(accept_encoding, codings[1]) > accept_quality(accept_encoding, codings[0])) {
+                std::swap(codings[0], codings[1]);
+            }
+            for (auto &coding : codings) {
+                if (accept_quality(accept_encoding, coding) == 0) { coding = content_coding::identity; }
+            }
+            return codings;
+        }
+    }// namespace detail
+
+    /** @brief Open the precompressed sibling of @a path ("file.br", "file.gz") preferred by @a accept_encoding.
+     *
+     * @return nullopt when no acceptable sibling exists.
+     */
+    inline std::optional<std::pair<file_body, content_coding>>
+        open_precompressed(std::filesystem::path const &path, std::string_view accept_encoding) {
+        for (auto coding : detail::precompressed_codings(accept_encoding)) {
+            if (coding == content_coding::identity) { break; }
+            auto sibling = path;
+            sibling += file_extension(coding);
+            struct stat status {};
+            if (::stat(sibling.c_str(), &status) == 0 and S_ISREG(status.st_mode)) {
+                return std::pair{file_body{sibling}, coding};
+            }
+        }
+        return {};
+    }
+
+    namespace detail {
+        // coding negotiated for a response, Vary header added when the response is compressible
+        template<typename Socket>
+        content_coding select_encoding(server_request<Socket> const &request, http::headers &headers) {
+            if (headers.contains("Content-Encoding")) { return content_coding::identity; }
+            if (auto content_type = headers.find("Content-Type");
+                content_type != headers.end() and not is_compressible(content_type->second)) {
+                return content_coding::identity;
+            }
+            headers.emplace("Vary", "Accept-Encoding");
+            return negotiate_encoding(request.header(header_id::accept_encoding),
+                                      {content_coding::gzip, content_coding::deflate});
+        }
+
+        inline web::deflater_pool::pointer acquire_deflater(content_coding coding, compression_options const &options) {
+            // gzip: zlib window + 16
+            return web::deflater_pool::local().acquire(options.level, coding == content_coding::gzip ? 31 : 15);
+        }
+    }// namespace detail
+
+    /** @brief Send @a body, compressed with the coding negotiated from the request Accept-Encoding header.
+     *
+     * Bodies smaller than compression_options::min_size, already encoded or of an incompressible
+     * Content-Type are sent as is.
+     */
+    template<typename Socket>
+    task<size_t> async_send_encoded(server_session<Socket> &session, server_request<Socket> const &request,
+                                    http::status status, http::headers &&headers, span<std::byte const> body,
+                                    compression_options const &options = default_compression_options) {
+        auto coding = detail::select_encoding(request, headers);
+        if (coding == content_coding::identity or body.size() < options.min_size) {
+            co_return co_await net::async_send(session, status, std::move(headers), body);
+        }
+        auto deflater = detail::acquire_deflater(coding, options);
+        auto compressed = deflater->compress(body, Z_FINISH);
+        headers.emplace("Content-Encoding", to_string(coding));
+        co_return co_await net::async_send(session, status, std::move(headers), compressed);
+    }
+
+    /** @brief Chunked response compressed on the fly.
+     *
+     * Headers are sent once compression_options::min_size bytes are written, smaller bodies are sent
+     * uncompressed (with a Content-Length) when the response is closed.
+     * Each written chunk is flushed (Z_SYNC_FLUSH), so that streamed data is not delayed by the compressor.
+     */
+    template<typename Socket>
+    class encoded_response
+    {
+    public:
+        encoded_response(server_session<Socket> &session, server_request<Socket> const &request, http::status status,
+                         http::headers &&headers, compression_options const &options = default_compression_options)
+            : session_{&session}, status_{status}, headers_{std::move(headers)}, options_{&options} {
+            headers_.erase("Transfer-Encoding");
+            headers_.erase("Content-Length");
+            coding_ = detail::select_encoding(request, headers_);
+        }
+
+        encoded_response(encoded_response &&) noexcept = default;
+        encoded_response(encoded_response const &) = delete;
+
+        [[nodiscard]] content_coding coding() const noexcept { return coding_; }
+
+        template<typename T, size_t extent = unifex::dynamic_extent>
+        friend task<size_t> tag_invoke(unifex::tag_t<net::async_send>, encoded_response &response,
+                                       span<T, extent> data) {
+            auto bytes = as_bytes(span{data.data(), data.size()});
+            if (not response.response_) {
+                if (response.coding_ != content_coding::identity
+                    and response.pending_.size() + bytes.size() < response.options_->min_size) {
+                    response.pending_.append(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+                    co_return bytes.size();
+                }
+                co_await response.async_start();
+            }
+            co_await response.async_send_chunk(bytes, Z_SYNC_FLUSH);
+            co_return bytes.size();
+        }
+
+        friend task<void> tag_invoke(unifex::tag_t<net::async_send>, encoded_response &response) {
+            if (not response.response_) {
+                // small body: sent uncompressed
+                co_await net::async_send(*response.session_, response.status_, std::move(response.headers_),
+                                         as_bytes(span{response.pending_.data(), response.pending_.size()}));
+                co_return;
+            }
+            co_await response.async_send_chunk({}, Z_FINISH);
+            co_await net::async_send(*response.response_);
+        }
+
+    private:
+        task<void> async_start() {
+            if (coding_ != content_coding::identity) {
+                headers_.emplace("Content-Encoding", to_string(coding_));
+                deflater_ = detail::acquire_deflater(coding_, *options_);
+            }
+            headers_.emplace("Transfer-Encoding", "chunked");
+            response_.emplace(co_await net::async_send(*session_, status_, std::move(headers_)));
+            if (not pending_.empty()) {
+                co_await async_send_chunk(as_bytes(span{pending_.data(), pending_.size()}), Z_NO_FLUSH);
+                pending_.clear();
+            }
+        }
+
+        task<void> async_send_chunk(span<std::byte const> data, int flush) {
+            if (deflater_) { data = deflater_->compress(data, flush); }
+            // an empty chunk would terminate the body
+            if (not data.empty()) { co_await net::async_send(*response_, data); }
+        }
+
+        server_session<Socket> *session_;
+        http::status status_;
+        http::headers headers_;
+        compression_options const *options_;
+        content_coding coding_;
+        std::string pending_;
+        web::deflater_pool::pointer deflater_;
+        std::optional<server_response<Socket>> response_;
+    };
+
+}// namespace g6::http
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+namespace g6::http {
+
+    /** @brief File response body.
+     *
+     * The file is opened on construction (std::system_error thrown on failure) and
+     * sent with a Content-Length header (see server_session).
+     */
+    class file_body
+    {
+    public:
+        explicit file_body(std::filesystem::path const &path) : fd_{::open(path.c_str(), O_RDONLY | O_CLOEXEC)} {
+            if (fd_ < 0) { throw std::system_error{errno, std::system_category(), path.string()}; }
+            int error = ::fstat(fd_, &status_) != 0 ? errno : (S_ISREG(status_.st_mode) ? 0 : EISDIR);
+            if (error) {
+                ::close(fd_);
+                throw std::system_error{error, std::system_category(), path.string()};
+            }
+            size_ = size_t(status_.st_size);
+        }
+
+        file_body(file_body &&other) noexcept
+            : fd_{std::exchange(other.fd_, -1)}, status_{other.status_}, offset_{other.offset_}, size_{other.size_} {}
+        file_body(file_body const &) = delete;
+
+        ~file_body() noexcept {
+            if (fd_ >= 0) { ::close(fd_); }
+        }
+
+        [[nodiscard]] int native_handle() const noexcept { return fd_; }
+        [[nodiscard]] struct stat const &status() const noexcept { return status_; }
+        [[nodiscard]] size_t file_size() const noexcept { return size_t(status_.st_size); }
+
+        // sent part of the file (whole file by default)
+        [[nodiscard]] off_t offset() const noexcept { return offset_; }
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+
+        /** @brief Restrict the body to @a size bytes starting at @a offset.
+         */
+        file_body &range(off_t offset, size_t size) noexcept {
+            offset_ = offset;
+            size_ = size;
+            return *this;
+        }
+
+    private:
+        int fd_;
+        struct stat status_ {};
+        off_t offset_{0};
+        size_t size_{0};
+    };
+
+}// namespace g6::http
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <g6/http/session.hpp>
+
+#include <g6/web/buffer.hpp>
+
+#include <unifex/file_concepts.hpp>
+#include <unifex/scope_guard.hpp>
+#include <unifex/span.hpp>
+#include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
+
+#include <array>
+#include <cstring>
+#include <system_error>
+
+namespace g6::http {
+
+    namespace detail {
+        template<typename File>
+        task<void> async_write_all_at(File &file, size_t offset, span<std::byte const> data) {
+            while (not data.empty()) {
+                size_t bytes = co_await async_write_some_at(file, offset, data);
+                if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::io_error), "short write"}; }
+                offset += bytes;
+                data = data.subspan(bytes);
+            }
+        }
+    }// namespace detail
+
+    /** @brief Receive the request body into @a file, starting at @a offset.
+     *
+     * Body parts are gathered into two pooled buffers of @a buffer_size bytes: one buffer is written
+     * to the file (async_write_some_at) while the other one is filled from the connection,
+     * so that memory usage does not depend on the body size.
+     *
+     * @return Number of body bytes written.
+     */
+    template<typename Socket, typename File>
+    task<size_t> async_recv_to_file(server_request<Socket> &request, File &file, size_t offset = 0,
+                                    size_t buffer_size = 256 * 1024) {
+        auto &pool = web::buffer_pool::local();
+        std::array<span<std::byte>, 2> buffers{};
+        scope_guard release = [&]() noexcept {
+            for (auto buffer : buffers) {
+                if (not buffer.empty()) { pool.release(buffer); }
+            }
+        };
+        buffers[0] = pool.acquire(buffer_size);
+        buffers[1] = pool.acquire(buffer_size);
+
+        // received body bytes that did not fit in the buffer being filled
+        span<std::byte const> leftover{};
+        auto async_fill = [&](span<std::byte> buffer, size_t &size) -> task<void> {
+            size = 0;
+            while (size < buffer.size() and (not leftover.empty() or net::has_pending_data(request))) {
+                if (leftover.empty()) {
+                    leftover = co_await net::async_recv(request);
+                    continue;
+                }
+                size_t count = std::min(leftover.size(), buffer.size() - size);
+                std::memcpy(buffer.data() + size, leftover.data(), count);
+                size += count;
+                leftover = leftover.subspan(count);
+            }
+        };
+
+        size_t written = 0;
+        std::array<size_t, 2> sizes{};
+        co_await async_fill(buffers[0], sizes[0]);
+        for (size_t current = 0; sizes[current] != 0; current ^= 1) {
+            auto data = buffers[current].first(sizes[current]);
+            co_await when_all(detail::async_write_all_at(file, offset + written, data),
+                              async_fill(buffers[current ^ 1], sizes[current ^ 1]));
+            written += sizes[current];
+        }
+        co_return written;
+    }
+
+}// namespace g6::http
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <g6/http/http.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace g6::http {
+
+    namespace detail {
+        constexpr char to_lower(char c) noexcept { return (c >= 'A' and c <= 'Z') ? char(c - 'A' + 'a') : c; }
+
+        constexpr bool iequals(std::string_view lhs, std::string_view rhs) noexcept {
+            return lhs.size() == rhs.size()
+               and std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                              [](char l, char r) { return to_lower(l) == to_lower(r); });
+        }
+
+        struct known_header {
+            std::string_view name;
+            header_id id;
+        };
+
+        inline constexpr auto known_headers = [] {
+            std::array<known_header, header_id_count> headers{{
+#define XX(num, name, string) {string, header_id::name},
+                G6_HTTP_HEADER_MAP(XX)
+#undef XX
+            }};
+            std::sort(headers.begin(), headers.end(),
+                      [](auto const &lhs, auto const &rhs) { return lhs.name.size() < rhs.name.size(); });
+            return headers;
+        }();
+
+        inline constexpr size_t max_known_header_size = known_headers.back().name.size();
+
+        // known_headers index of the first name of each length
+        inline constexpr auto known_header_offsets = [] {
+            std::array<uint8_t, max_known_header_size + 2> offsets{};
+            size_t index = 0;
+            for (size_t size = 0; size < offsets.size(); ++size) {
+                while (index < known_headers.size() and known_headers[index].name.size() < size) { ++index; }
+                offsets[size] = uint8_t(index);
+            }
+            return offsets;
+        }();
+
+        /** @brief Well-known header identification (case-insensitive).
+         *
+         * Candidates are selected by length, then compared on first character before full comparison.
+         */
+        constexpr header_id classify_header(std::string_view field) noexcept {
+            if (field.empty() or field.size() > max_known_header_size) { return header_id::unknown; }
+            const char first = to_lower(field.front());
+            for (size_t ii = known_header_offsets[field.size()]; ii < known_header_offsets[field.size() + 1]; ++ii) {
+                auto const &candidate = known_headers[ii];
+                if (to_lower(candidate.name.front()) == first and iequals(candidate.name, field)) {
+                    return candidate.id;
+                }
+            }
+            return header_id::unknown;
+        }
+
+        static_assert(classify_header("content-length") == header_id::content_length);
+        static_assert(classify_header("SEC-WEBSOCKET-KEY") == header_id::sec_websocket_key);
+        static_assert(classify_header("X-Custom") == header_id::unknown);
+    }// namespace detail
+
+    /** @brief Look for @a token in a comma-separated header value (eg.: "Connection: keep-alive, Upgrade").
+     */
+    constexpr bool has_token(std::string_view value, std::string_view token) noexcept {
+        while (not value.empty()) {
+            auto separator = value.find(',');
+            auto item = value.substr(0, separator);
+            value = separator == std::string_view::npos ? std::string_view{} : value.substr(separator + 1);
+            auto first = item.find_first_not_of(" \t");
+            if (first == std::string_view::npos) { continue; }
+            item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+            if (detail::iequals(item, token)) { return true; }
+        }
+        return false;
+    }
+
+    static_assert(has_token("keep-alive, Upgrade", "upgrade"));
+    static_assert(not has_token("keep-alive", "upgrade"));
+
+    /** @brief Bump allocator for strings that must outlive the receive buffer.
+     *
+     * Memory is only given back on clear (the first block is kept for reuse).
+     */
+    class string_arena
+    {
+    public:
+        static constexpr size_t block_size = 1024;
+
+        std::string_view store(std::string_view str) { return concat(str, {}); }
+
+        std::string_view concat(std::string_view lhs, std::string_view rhs) {
+            char *out = allocate(lhs.size() + rhs.size());
+            if (not lhs.empty()) { std::memcpy(out, lhs.data(), lhs.size()); }
+            if (not rhs.empty()) { std::memcpy(out + lhs.size(), rhs.data(), rhs.size()); }
+            return {out, lhs.size() + rhs.size()};
+        }
+
+        void clear() noexcept {
+            if (blocks_.size() > 1) {
+                blocks_.resize(1);
+                capacity_ = front_capacity_;
+            }
+            used_ = 0;
+        }
+
+    private:
+        char *allocate(size_t size) {
+            if (blocks_.empty() or used_ + size > capacity_) {
+                capacity_ = std::max(block_size, size);
+                if (blocks_.empty()) { front_capacity_ = capacity_; }
+                blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(capacity_));
+                used_ = 0;
+            }
+            char *out = blocks_.back().get() + used_;
+            used_ += size;
+            return out;
+        }
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        size_t capacity_{0};
+        size_t front_capacity_{0};
+        size_t used_{0};
+    };
+
+    /** @brief Received message headers.
+     *
+     * Fields and values are views into the receive buffer, entries are stored in a flat vector
+     * (received order) and looked up case-insensitively.
+     * Well-known fields are indexed by header_id once complete (first occurrence), other ones are
+     * kept in an overflow list searched linearly.
+     * Views are moved to a per-message arena (see detach) before the receive buffer is reused
+     * while the message is still being parsed, or when a field/value is cut between two receives.
+     */
+    class header_map
+    {
+    public:
+        using value_type = std::pair<std::string_view, std::string_view>;
+        using const_iterator = std::vector<value_type>::const_iterator;
+        using iterator = const_iterator;
+
+        header_map() = default;
+        header_map(header_map &&) noexcept = default;
+        header_map &operator=(header_map &&) noexcept = default;
+        header_map(header_map const &) = delete;
+        header_map &operator=(header_map const &) = delete;
+
+        [[nodiscard]] const_iterator begin() const noexcept { return entries_.begin(); }
+        [[nodiscard]] const_iterator end() const noexcept { return entries_.end(); }
+        [[nodiscard]] size_t size() const noexcept { return entries_.size(); }
+        [[nodiscard]] bool empty() const noexcept { return entries_.empty(); }
+
+        [[nodiscard]] const_iterator find(header_id id) const noexcept {
+            if (id == header_id::unknown or slots_[size_t(id)] == 0) { return end(); }
+            return begin() + (slots_[size_t(id)] - 1);
+        }
+
+        [[nodiscard]] const_iterator find(std::string_view field) const noexcept {
+            if (auto id = detail::classify_header(field); id != header_id::unknown) { return find(id); }
+            for (auto index : overflow_) {
+                if (detail::iequals(entries_[index].first, field)) { return begin() + index; }
+            }
+            return end();
+        }
+
+        template<typename Key>
+        [[nodiscard]] bool contains(Key const &field) const noexcept {
+            return find(field) != end();
+        }
+
+        /** @brief Value of the first @a field header, empty when missing.
+         */
+        template<typename Key>
+        [[nodiscard]] std::string_view value(Key const &field) const noexcept {
+            auto it = find(field);
+            return it == end() ? std::string_view{} : it->second;
+        }
+
+        template<typename Key>
+        [[nodiscard]] std::string_view at(Key const &field) const {
+            auto it = find(field);
+            if (it == end()) { throw std::out_of_range("header not found: " + std::string{key_name(field)}); }
+            return it->second;
+        }
+
+        void clear() noexcept {
+            entries_.clear();
+            arena_.clear();
+            slots_.fill(0);
+            overflow_.clear();
+            detached_ = 0;
+            indexed_ = 0;
+        }
+
+        // parser interface
+
+        void add_field(std::string_view field) {
+            index();
+            entries_.emplace_back(field, std::string_view{});
+        }
+
+        /** @brief Index the last field (headers or trailers are complete).
+         */
+        void complete() { index(); }
+
+        // field/value continued in a next receive: the previous part has already been detached
+        void append_field(std::string_view data) {
+            entries_.back().first = arena_.concat(entries_.back().first, data);
+        }
+
+        void append_value(std::string_view data) {
+            auto &value = entries_.back().second;
+            value = value.empty() ? data : arena_.concat(value, data);
+        }
+
+        /** @brief Copy the entries still referencing the receive buffer into the arena.
+         */
+        void detach() {
+            for (; detached_ < entries_.size(); ++detached_) {
+                auto &[field, value] = entries_[detached_];
+                field = arena_.store(field);
+                value = arena_.store(value);
+            }
+            if (not entries_.empty()) {
+                // the last entry might still be extended with buffer views
+                detached_ = entries_.size() - 1;
+            }
+        }
+
+    private:
+        static std::string_view key_name(header_id id) noexcept { return to_string(id); }
+        static std::string_view key_name(std::string_view field) noexcept { return field; }
+
+        void index() {
+            for (; indexed_ < entries_.size(); ++indexed_) {
+                if (auto id = detail::classify_header(entries_[indexed_].first); id == header_id::unknown) {
+                    overflow_.push_back(uint32_t(indexed_));
+                } else if (slots_[size_t(id)] == 0) {
+                    slots_[size_t(id)] = uint32_t(indexed_ + 1);
+                }
+            }
+        }
+
+        std::vector<value_type> entries_;
+        string_arena arena_;
+        // entries_ index + 1 of well-known fields (0 when missing)
+        std::array<uint32_t, header_id_count> slots_{};
+        // entries_ index of other fields
+        std::vector<uint32_t> overflow_;
+        // number of entries already living in the arena
+        size_t detached_{0};
+        // number of classified entries
+        size_t indexed_{0};
+    };
+
+}// namespace g6::http
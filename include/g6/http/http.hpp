@@ -2,6 +2,8 @@
 
 #include <map>
 #include <string>
+#include <string_view>
+#include <system_error>
 
 namespace g6::http {
     namespace detail {
@@ -77,6 +79,63 @@ namespace g6::http {
 #undef XX
     };
 
+/* Well-known header fields */
+#define G6_HTTP_HEADER_MAP(XX)                                                                                         \
+    XX(0, accept, "Accept")                                                                                            \
+    XX(1, accept_charset, "Accept-Charset")                                                                            \
+    XX(2, accept_encoding, "Accept-Encoding")                                                                          \
+    XX(3, accept_language, "Accept-Language")                                                                          \
+    XX(4, accept_ranges, "Accept-Ranges")                                                                              \
+    XX(5, age, "Age")                                                                                                  \
+    XX(6, allow, "Allow")                                                                                              \
+    XX(7, authorization, "Authorization")                                                                              \
+    XX(8, cache_control, "Cache-Control")                                                                              \
+    XX(9, connection, "Connection")                                                                                    \
+    XX(10, content_disposition, "Content-Disposition")                                                                 \
+    XX(11, content_encoding, "Content-Encoding")                                                                       \
+    XX(12, content_language, "Content-Language")                                                                       \
+    XX(13, content_length, "Content-Length")                                                                           \
+    XX(14, content_location, "Content-Location")                                                                       \
+    XX(15, content_range, "Content-Range")                                                                             \
+    XX(16, content_type, "Content-Type")                                                                               \
+    XX(17, cookie, "Cookie")                                                                                           \
+    XX(18, date, "Date")                                                                                               \
+    XX(19, etag, "ETag")                                                                                               \
+    XX(20, expect, "Expect")                                                                                           \
+    XX(21, expires, "Expires")                                                                                         \
+    XX(22, forwarded, "Forwarded")                                                                                     \
+    XX(23, host, "Host")                                                                                               \
+    XX(24, if_match, "If-Match")                                                                                       \
+    XX(25, if_modified_since, "If-Modified-Since")                                                                     \
+    XX(26, if_none_match, "If-None-Match")                                                                             \
+    XX(27, if_range, "If-Range")                                                                                       \
+    XX(28, if_unmodified_since, "If-Unmodified-Since")                                                                 \
+    XX(29, keep_alive, "Keep-Alive")                                                                                   \
+    XX(30, last_modified, "Last-Modified")                                                                             \
+    XX(31, location, "Location")                                                                                       \
+    XX(32, origin, "Origin")                                                                                           \
+    XX(33, pragma, "Pragma")                                                                                           \
+    XX(34, proxy_authorization, "Proxy-Authorization")                                                                 \
+    XX(35, range, "Range")                                                                                             \
+    XX(36, referer, "Referer")                                                                                         \
+    XX(37, retry_after, "Retry-After")                                                                                 \
+    XX(38, sec_websocket_accept, "Sec-WebSocket-Accept")                                                               \
+    XX(39, sec_websocket_extensions, "Sec-WebSocket-Extensions")                                                       \
+    XX(40, sec_websocket_key, "Sec-WebSocket-Key")                                                                     \
+    XX(41, sec_websocket_protocol, "Sec-WebSocket-Protocol")                                                           \
+    XX(42, sec_websocket_version, "Sec-WebSocket-Version")                                                             \
+    XX(43, server, "Server")                                                                                           \
+    XX(44, set_cookie, "Set-Cookie")                                                                                   \
+    XX(45, te, "TE")                                                                                                   \
+    XX(46, trailer, "Trailer")                                                                                         \
+    XX(47, transfer_encoding, "Transfer-Encoding")                                                                     \
+    XX(48, upgrade, "Upgrade")                                                                                         \
+    XX(49, user_agent, "User-Agent")                                                                                   \
+    XX(50, vary, "Vary")                                                                                               \
+    XX(51, via, "Via")                                                                                                 \
+    XX(52, www_authenticate, "WWW-Authenticate")                                                                       \
+    XX(53, x_forwarded_for, "X-Forwarded-For")
+
 /* Request Methods */
 #define G6_HTTP_METHOD_MAP(XX)                                                                                         \
     XX(0, delete_, DELETE)                                                                                             \
@@ -131,6 +190,37 @@ namespace g6::http {
 
     using headers = std::multimap<std::string, std::string>;
 
+    /** @brief Chunked body tag (Transfer-Encoding: chunked).
+     */
+    inline constexpr struct chunked_t {
+    } chunked{};
+
+    /** @brief Well-known header fields.
+     *
+     * Received headers are classified at parse time, so that well-known ones are looked up by index.
+     */
+    enum class header_id
+    {
+#define XX(num, name, string) name = num,
+        G6_HTTP_HEADER_MAP(XX)
+#undef XX
+        unknown,
+    };
+
+    constexpr size_t header_id_count = size_t(header_id::unknown);
+
+    constexpr std::string_view to_string(header_id id) noexcept {
+        switch (id) {
+#define XX(num, name, string)                                                                                          \
+    case header_id::name:                                                                                              \
+        return string;
+            G6_HTTP_HEADER_MAP(XX)
+#undef XX
+            default:
+                return {};
+        }
+    }
+
     struct error_category_t final : std::error_category {
         [[nodiscard]] const char *name() const noexcept final { return "http"; }
         [[nodiscard]] std::string message(int error) const noexcept final {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <g6/http/header_map.hpp>
 #include <g6/http/http.hpp>
 #include <g6/utils/c_ptr.hpp>
 #include <g6/web/uri.hpp>
@@ -44,19 +45,20 @@ namespace g6::http::detail {
 
         static_parser_handler() = default;
         static_parser_handler(static_parser_handler &&other) noexcept
-            : parser_{std::move(other.parser_)}, header_field_{std::move(other.header_field_)}, url_{std::move(
-                                                                                                    other.url_)},
-              body_{std::move(other.body_)}, state_{std::move(other.state_)}, headers_{std::move(other.headers_)} {
+            : parser_{std::move(other.parser_)}, target_{std::move(other.target_)}, url_{std::move(other.url_)},
+              body_{std::move(other.body_)},
+              state_{std::move(other.state_)}, headers_{std::move(other.headers_)}, skip_body_{other.skip_body_} {
             parser_->data = this;
         }
 
         static_parser_handler &operator=(static_parser_handler &&other) noexcept {
             parser_ = std::move(other.parser_);
-            header_field_ = std::move(other.header_field_);
+            target_ = std::move(other.target_);
             url_ = std::move(other.url_);
             body_ = std::move(other.body_);
             state_ = std::move(other.state_);
             headers_ = std::move(other.headers_);
+            skip_body_ = other.skip_body_;
             parser_->data = this;
             return *this;
         }
@@ -64,9 +66,8 @@ namespace g6::http::detail {
         static_parser_handler &operator=(const static_parser_handler &) noexcept = delete;
 
         std::optional<size_t> content_length() const noexcept {
-            if (headers_.contains("Content-Length")) {
-                auto it = headers_.find("Content-Length");
-                unifex::span view{it->second.data(), it->second.size()};
+            if (auto it = headers_.find(header_id::content_length); it != headers_.end()) {
+                auto view = it->second;
                 size_t sz = 0;
                 auto [ptr, error] = std::from_chars(view.data(), view.data() + view.size(), sz);
                 assert(error == std::errc{});
@@ -81,30 +82,46 @@ namespace g6::http::detail {
         [[nodiscard]] auto body() { return std::exchange(body_, {}); }
         [[nodiscard]] size_t body_size() const { return body_.size(); }
 
+        /** @brief Move headers out of the receive buffer (before it gets reused).
+         */
+        void detach_headers() { headers_.detach(); }
+
+        /** @brief Ignore the message body (responses to HEAD requests).
+         */
+        void skip_body(bool skip) noexcept { skip_body_ = skip; }
+
     public:
-        bool parse(unifex::span<std::byte const> data) {
+        /** @brief Feed the parser.
+         *
+         * Parsing pauses after each body part and at the end of the message, so that body parts are
+         * handed one by one and bytes belonging to a next (pipelined) message are left untouched.
+         *
+         * @return Number of bytes consumed.
+         */
+        size_t parse(unifex::span<std::byte const> data) {
             body_ = {};
+            detail::http_parser_pause(parser_.get(), 0);
             const auto count =
                 execute_parser(reinterpret_cast<const char *>(unifex::as_bytes(data).data()), data.size());
-            if (count < data.size()) {
+            if (count < data.size() and detail::http_errno(parser_->http_errno) != detail::HPE_PAUSED) {
                 throw std::runtime_error{fmt::format(FMT_STRING("parse error: {}"),
                                                      http_errno_description(detail::http_errno(parser_->http_errno)))};
             }
-            return state_ == parser_status::on_message_complete;
+            return count;
         }
 
-        [[nodiscard]] bool chunked() const {
-            if (parser_->uses_transfer_encoding) {
-                return header_at("Transfer-Encoding") == std::string_view{"chunked"};
-            } else {
-                return false;
-            }
-        }
+        [[nodiscard]] bool chunked() const noexcept { return parser_->flags & detail::F_CHUNKED; }
 
         friend bool tag_invoke(unifex::tag_t<net::has_pending_data>, static_parser_handler &sph) noexcept {
             return (sph.state_ != parser_status::on_message_complete) || (not sph.body_.empty());
         }
 
+        [[nodiscard]] bool keep_alive() const noexcept { return detail::http_should_keep_alive(parser_.get()); }
+
+        [[nodiscard]] std::pair<int, int> http_version() const noexcept {
+            return {parser_->http_major, parser_->http_minor};
+        }
+
         auto method() const { return static_cast<http::method>(parser_->method); }
         auto status_code() const { return static_cast<http::status>(parser_->status_code); }
 
@@ -116,8 +133,17 @@ namespace g6::http::detail {
             }
         }
 
+        /** @brief Decoded request target.
+         */
         const auto &url() const { return url_; }
-        auto uri() const { return web::uri{url_}; }
+
+        /** @brief Request target, as received (percent-encoded).
+         */
+        std::string_view target() const noexcept { return target_; }
+
+        /** @brief Request target view (valid until the next message is parsed).
+         */
+        web::uri uri() const noexcept { return web::uri{target_}; }
 
         auto &url() { return url_; }
 
@@ -134,25 +160,14 @@ namespace g6::http::detail {
             return out.data();
         }
 
-        auto &headers() { return headers_; }
+        auto const &headers() const { return headers_; }
 
-        auto &header(const std::string &key) {
-            auto it = headers_.find(key);
-            if (it == headers_.end()) {
-                return headers_.emplace(key, "")->second;
-            } else {
-                return it->second;
-            }
-        }
+        // empty when not found
+        std::string_view header(std::string_view key) const noexcept { return headers_.value(key); }
+        std::string_view header(header_id id) const noexcept { return headers_.value(id); }
 
-        auto const &header_at(const std::string &key) const {
-            auto it = headers_.find(key);
-            if (it == headers_.end()) {
-                throw std::out_of_range("header not found: " + key);
-            } else {
-                return it->second;
-            }
-        }
+        std::string_view header_at(std::string_view key) const { return headers_.at(key); }
+        std::string_view header_at(header_id id) const { return headers_.at(id); }
 
     protected:
         enum class parser_status
@@ -174,13 +189,18 @@ namespace g6::http::detail {
 
         static inline int on_message_begin(detail::http_parser *parser) {
             auto &this_ = instance(parser);
+            // parser might be reused for a next message (keep-alive)
+            this_.target_.clear();
+            this_.url_.clear();
+            this_.headers_.clear();
             this_.state_ = parser_status::on_message_begin;
             return 0;
         }
 
         static inline int on_url(detail::http_parser *parser, const char *data, size_t len) {
             auto &this_ = instance(parser);
-            this_.url_ = web::uri::unescape({data, len});
+            // target might have been cut
+            this_.target_.append(data, len);
             this_.state_ = parser_status::on_url;
             return 0;
         }
@@ -193,21 +213,20 @@ namespace g6::http::detail {
 
         static inline int on_header_field(detail::http_parser *parser, const char *data, size_t len) {
             auto &this_ = instance(parser);
+            if (this_.state_ == parser_status::on_header_field) {
+                // header field has been cut
+                this_.headers_.append_field({data, len});
+            } else {
+                this_.headers_.add_field({data, len});
+            }
             this_.state_ = parser_status::on_header_field;
-            this_.header_field_ = {data, len};
             return 0;
         }
 
         static inline int on_header_value(detail::http_parser *parser, const char *data, size_t len) {
             auto &this_ = instance(parser);
-            if (this_.state_ == parser_status::on_header_field) {
-                this_.headers_.emplace(this_.header_field_, std::string{data, data + len});
-            } else {
-                // header has been cut
-                auto it = this_.headers_.find(this_.header_field_);
-                assert(it != this_.headers_.end());
-                it->second.append(std::string_view{data, data + len});
-            }
+            // header value might have been cut
+            this_.headers_.append_value({data, len});
             this_.state_ = parser_status::on_header_value;
 
             return 0;
@@ -215,20 +234,27 @@ namespace g6::http::detail {
 
         static inline int on_headers_complete(detail::http_parser *parser) {
             auto &this_ = instance(parser);
+            this_.headers_.complete();
+            if constexpr (is_request) { web::uri::unescape(this_.target_, this_.url_); }
             this_.state_ = parser_status::on_headers_complete;
-            return 0;
+            // 1: no body
+            return this_.skip_body_ ? 1 : 0;
         }
 
         static inline int on_body(detail::http_parser *parser, const char *data, size_t len) {
             auto &this_ = instance(parser);
             this_.body_ = unifex::as_writable_bytes(unifex::span{const_cast<char *>(data), len});
             this_.state_ = parser_status::on_body;
+            detail::http_parser_pause(parser, 1);
             return 0;
         }
 
         static inline int on_message_complete(detail::http_parser *parser) {
             auto &this_ = instance(parser);
+            // trailers
+            this_.headers_.complete();
             this_.state_ = parser_status::on_message_complete;
+            detail::http_parser_pause(parser, 1);
             return 0;
         }
 
@@ -255,10 +281,12 @@ namespace g6::http::detail {
             on_headers_complete, on_body, on_message_complete, on_chunk_header, on_chunk_complete,
         };
         parser_status state_{parser_status::none};
-        std::string header_field_;
+        // raw request target, its capacity is kept between messages
+        std::string target_;
         std::string url_;
         unifex::span<std::byte> body_;
-        http::headers headers_;
+        http::header_map headers_;
+        bool skip_body_{false};
 
         //		template<bool _is_response, is_body BodyT>
         //		friend struct abstract_message;
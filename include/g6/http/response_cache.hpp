@@ -0,0 +1,280 @@
+#pragma once
+
+#include <g6/http/content_encoding.hpp>
+#include <g6/http/file_body.hpp>
+#include <g6/http/http.hpp>
+#include <g6/http/session.hpp>
+#include <g6/http/static_file.hpp>
+
+#include <unifex/task.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace g6::http {
+
+    /** @brief Size-bounded LRU cache of pre-serialized file responses.
+     *
+     * Entries hold the status line, headers and body in a single buffer, so that hits are sent
+     * with a single write. Entries are revalidated against the file modification time (at most once per
+     * options::check_interval).
+     * The cache is not thread-safe: use one cache per io context (eg.: per sharded_server shard).
+     */
+    class response_cache
+    {
+    public:
+        struct options {
+            // total size of cached responses
+            size_t max_size = 64 * 1024 * 1024;
+            // larger files are not cached (sent with sendfile)
+            size_t max_entry_size = 1024 * 1024;
+            // minimum time between two modification checks of an entry
+            std::chrono::milliseconds check_interval = std::chrono::seconds{1};
+        };
+
+        struct stats {
+            // requests served from a cached response (see async_send_cached_file)
+            size_t hits = 0;
+            // requests that needed the file to be (re)loaded, or that were not cacheable
+            size_t misses = 0;
+            size_t evictions = 0;
+            size_t invalidations = 0;
+            size_t size = 0;
+            size_t entries = 0;
+        };
+
+        struct entry {
+            // file path (precompressed sibling path for encoded entries)
+            std::string path;
+            // false for missing precompressed siblings (avoids looking them up on each request)
+            bool exists = true;
+            content_coding coding = content_coding::identity;
+            // head (without terminating empty line) followed by body
+            std::string data;
+            size_t head_size = 0;
+            std::string etag;
+            std::string last_modified;
+            ino_t inode{};
+            off_t file_size{};
+            struct timespec mtim {};
+            std::chrono::steady_clock::time_point checked_at;
+
+            [[nodiscard]] span<std::byte const> head() const noexcept { return as_bytes(span{data.data(), head_size}); }
+            [[nodiscard]] span<std::byte const> body() const noexcept {
+                return as_bytes(span{data.data() + head_size, data.size() - head_size});
+            }
+        };
+
+        response_cache() : response_cache(options{}) {}
+        explicit response_cache(options const &options) : options_{options} {}
+
+        response_cache(response_cache const &) = delete;
+        response_cache &operator=(response_cache const &) = delete;
+
+        /** @brief Get the (up-to-date) cached response for @a path, loading it on miss.
+         *
+         * @param coding Precompressed representation (@a path sibling with the coding file extension).
+         * @return nullptr when the file is too large to be cached, or when the precompressed sibling does not exist.
+         * @throws std::system_error when the file cannot be opened.
+         */
+        std::shared_ptr<entry const> lookup(std::filesystem::path const &path,
+                                            content_coding coding = content_coding::identity) {
+            auto [found, loaded] = find(path, coding);
+            // missing precompressed siblings are not counted
+            if (found or coding == content_coding::identity) { ++(found and not loaded ? stats_.hits : stats_.misses); }
+            return found;
+        }
+
+        void clear() noexcept {
+            lru_.clear();
+            index_.clear();
+            stats_.size = 0;
+            stats_.entries = 0;
+        }
+
+        [[nodiscard]] stats const &statistics() const noexcept { return stats_; }
+
+    private:
+        using lru_list = std::list<std::shared_ptr<entry>>;
+
+        template<typename Socket>
+        friend task<void> async_send_cached_file(response_cache &cache, server_session<Socket> &session,
+                                                 server_request<Socket> const &request,
+                                                 std::filesystem::path const &path);
+
+        // (up-to-date) entry, and whether it has been loaded (not found in the cache) - statistics are not updated
+        std::pair<std::shared_ptr<entry const>, bool> find(std::filesystem::path const &path, content_coding coding) {
+            auto now = std::chrono::steady_clock::now();
+            auto file_path = path.native();
+            file_path += file_extension(coding);
+            if (auto it = index_.find(file_path); it != index_.end()) {
+                auto entry_it = it->second;
+                if (now - (*entry_it)->checked_at < options_.check_interval or still_valid(**entry_it, now)) {
+                    lru_.splice(lru_.begin(), lru_, entry_it);
+                    return {(*entry_it)->exists ? *entry_it : nullptr, false};
+                }
+                ++stats_.invalidations;
+                erase(entry_it);
+            }
+            auto loaded = load(path, std::move(file_path), coding, now);
+            if (loaded) { insert(loaded); }
+            return {loaded and loaded->exists ? loaded : nullptr, true};
+        }
+
+        // modification check, refreshes checked_at when unchanged
+        static bool still_valid(entry &e, std::chrono::steady_clock::time_point now) noexcept {
+            struct stat status {};
+            const bool exists = ::stat(e.path.c_str(), &status) == 0;
+            if (exists != e.exists
+                or (exists
+                    and (status.st_ino != e.inode or status.st_size != e.file_size
+                         or status.st_mtim.tv_sec != e.mtim.tv_sec or status.st_mtim.tv_nsec != e.mtim.tv_nsec))) {
+                return false;
+            }
+            e.checked_at = now;
+            return true;
+        }
+
+        std::shared_ptr<entry> load(std::filesystem::path const &path, std::string file_path, content_coding coding,
+                                    std::chrono::steady_clock::time_point now) {
+            auto e = std::make_shared<entry>();
+            e->path = std::move(file_path);
+            e->coding = coding;
+            e->checked_at = now;
+            struct stat sibling_status {};
+            if (coding != content_coding::identity
+                and (::stat(e->path.c_str(), &sibling_status) != 0 or not S_ISREG(sibling_status.st_mode))) {
+                e->exists = false;
+                return e;
+            }
+            http::file_body file{e->path};
+            auto const &status = file.status();
+            if (file.file_size() > options_.max_entry_size) { return {}; }
+            const auto content_type = mime_type(path);
+            e->etag = make_etag(status);
+            e->last_modified = format_http_date(status.st_mtim.tv_sec);
+            e->inode = status.st_ino;
+            e->file_size = status.st_size;
+            e->mtim = status.st_mtim;
+            e->data = fmt::format("HTTP/1.1 200 OK\r\n"
+                                  "UserAgent: g6-http/0.0\r\n"
+                                  "Content-Type: {}\r\n"
+                                  "Content-Length: {}\r\n"
+                                  "ETag: {}\r\n"
+                                  "Last-Modified: {}\r\n"
+                                  "Accept-Ranges: bytes\r\n",
+                                  content_type, file.file_size(), e->etag, e->last_modified);
+            if (is_compressible(content_type)) { e->data += "Vary: Accept-Encoding\r\n"; }
+            if (coding != content_coding::identity) {
+                e->data += fmt::format("Content-Encoding: {}\r\n", to_string(coding));
+            }
+            e->head_size = e->data.size();
+            e->data.resize(e->head_size + file.file_size());
+            size_t offset = 0;
+            while (offset < file.file_size()) {
+                ssize_t bytes = ::pread(file.native_handle(), e->data.data() + e->head_size + offset,
+                                        file.file_size() - offset, off_t(offset));
+                if (bytes < 0) { throw std::system_error{errno, std::system_category(), "pread"}; }
+                if (bytes == 0) {
+                    throw std::system_error{std::make_error_code(std::errc::io_error), "truncated file"};
+                }
+                offset += size_t(bytes);
+            }
+            return e;
+        }
+
+        void insert(std::shared_ptr<entry> const &e) {
+            if (e->data.size() > options_.max_size) { return; }
+            while (not lru_.empty() and stats_.size + e->data.size() > options_.max_size) {
+                ++stats_.evictions;
+                erase(std::prev(lru_.end()));
+            }
+            lru_.push_front(e);
+            index_.emplace(e->path, lru_.begin());
+            stats_.size += e->data.size();
+            ++stats_.entries;
+        }
+
+        void erase(lru_list::iterator it) noexcept {
+            stats_.size -= (*it)->data.size();
+            --stats_.entries;
+            index_.erase((*it)->path);
+            lru_.erase(it);
+        }
+
+        options options_;
+        stats stats_{};
+        lru_list lru_;
+        std::unordered_map<std::string, lru_list::iterator> index_;
+    };
+
+    /** @brief Respond to @a request with the file at @a path, through @a cache.
+     *
+     * Cached responses are sent with a single write, revalidation requests (If-None-Match, If-Modified-Since)
+     * are answered from the cache. Precompressed siblings are cached as separate entries.
+     * Range requests, methods other than GET and HEAD, and uncacheable files go through async_send_static_file.
+     *
+     * @throws std::system_error when the file cannot be opened.
+     */
+    template<typename Socket>
+    task<void> async_send_cached_file(response_cache &cache, server_session<Socket> &session,
+                                      server_request<Socket> const &request, std::filesystem::path const &path) {
+        if (auto method = request.method(); (method != http::method::get and method != http::method::head)
+                                            or not request.header(header_id::range).empty()) {
+            co_await async_send_static_file(session, request, path);
+            co_return;
+        }
+        std::shared_ptr<response_cache::entry const> cached;
+        // counted once per request: a miss when any representation had to be loaded
+        bool loaded = false;
+        auto find = [&](content_coding coding) {
+            auto [found, found_loaded] = cache.find(path, coding);
+            // missing precompressed siblings are only loaded once, they do not make a miss afterwards
+            loaded = loaded or (found_loaded and (found or coding == content_coding::identity));
+            cached = std::move(found);
+        };
+        const bool compressible = is_compressible(mime_type(path));
+        if (auto accept_encoding = request.header(header_id::accept_encoding);
+            not accept_encoding.empty() and compressible) {
+            for (auto coding : detail::precompressed_codings(accept_encoding)) {
+                if (coding == content_coding::identity) { break; }
+                find(coding);
+                if (cached) { break; }
+            }
+        }
+        if (not cached) { find(content_coding::identity); }
+        if (not cached or loaded) {
+            ++cache.stats_.misses;
+        } else {
+            ++cache.stats_.hits;
+        }
+        if (not cached) {
+            co_await async_send_static_file(session, request, path);
+            co_return;
+        }
+        bool not_modified = false;
+        if (auto if_none_match = request.header(header_id::if_none_match); not if_none_match.empty()) {
+            not_modified = detail::etag_matches(if_none_match, cached->etag);
+        } else if (auto since = parse_http_date(request.header(header_id::if_modified_since))) {
+            not_modified = cached->mtim.tv_sec <= *since;
+        }
+        if (not_modified) {
+            http::headers headers{{"ETag", cached->etag}, {"Last-Modified", cached->last_modified}};
+            if (compressible) { headers.emplace("Vary", "Accept-Encoding"); }
+            co_await net::async_send(session, http::status::not_modified, std::move(headers),
+                                     span{static_cast<std::byte const *>(nullptr), 0});
+        } else if (request.method() == http::method::head) {
+            co_await session.async_send_serialized(cached->head(), {});
+        } else {
+            co_await session.async_send_serialized(cached->head(), cached->body());
+        }
+    }
+
+}// namespace g6::http
@@ -2,6 +2,20 @@
 
 #include <g6/router.hpp>
 #include <g6/http/http.hpp>
+#include <g6/http/session.hpp>
+
+#include <ctre.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace g6::http {
 
@@ -26,8 +40,407 @@ struct handler : g6::router::detail::handler<pattern, HandlerT> {
     }
   }
 };
+
+inline constexpr size_t method_count = std::max({
+#define XX(num, name, string) size_t{num},
+    G6_HTTP_METHOD_MAP(XX)
+#undef XX
+}) + 1;
+
+/** @brief Literal text every path matched by a route pattern starts with.
+ *
+ * exact: the pattern is the literal itself (no regex construct).
+ */
+template <size_t capacity> struct literal_prefix {
+  std::array<char, capacity> data{};
+  size_t size = 0;
+  bool exact = false;
+
+  [[nodiscard]] constexpr std::string_view view() const noexcept {
+    return {data.data(), size};
+  }
+};
+
+constexpr bool is_regex_special(char32_t c) noexcept {
+  return std::u32string_view{U"\\.[]()*+?{}|^$"}.find(c) !=
+         std::u32string_view::npos;
+}
+
+template <auto pattern> constexpr auto make_literal_prefix() noexcept {
+  literal_prefix<pattern.size() + 1> prefix{};
+  // top level alternation: no common prefix
+  for (size_t ii = 0, depth = 0; ii < pattern.size(); ++ii) {
+    if (pattern[ii] == U'\\') {
+      ++ii;
+    } else if (pattern[ii] == U'(' or pattern[ii] == U'[') {
+      ++depth;
+    } else if ((pattern[ii] == U')' or pattern[ii] == U']') and depth) {
+      --depth;
+    } else if (pattern[ii] == U'|' and depth == 0) {
+      return prefix;
+    }
+  }
+  size_t ii = 0;
+  while (ii < pattern.size()) {
+    char32_t c = pattern[ii];
+    size_t next = ii + 1;
+    if (c == U'\\') {
+      // escaped punctuation is literal, \d, \w, ... are classes
+      if (next == pattern.size() or pattern[next] > 0x7f or
+          (not is_regex_special(pattern[next]) and pattern[next] != U'/' and
+           pattern[next] != U'-')) {
+        return prefix;
+      }
+      c = pattern[next++];
+    } else if (c > 0x7f or is_regex_special(c)) {
+      return prefix;
+    }
+    if (next < pattern.size()) {
+      char32_t quantifier = pattern[next];
+      if (quantifier == U'*' or quantifier == U'?' or quantifier == U'{') {
+        // optional character
+        return prefix;
+      }
+      if (quantifier == U'+') {
+        prefix.data[prefix.size++] = char(c);
+        return prefix;
+      }
+    }
+    prefix.data[prefix.size++] = char(c);
+    ii = next;
+  }
+  prefix.exact = true;
+  return prefix;
+}
+
+static_assert(make_literal_prefix<ctll::fixed_string{"/api/users/(\\d+)"}>()
+                  .view() == "/api/users/");
+static_assert(make_literal_prefix<ctll::fixed_string{"/static\\.txt"}>()
+                  .exact);
+static_assert(make_literal_prefix<ctll::fixed_string{"/ab?c"}>().view() ==
+              "/a");
+static_assert(make_literal_prefix<ctll::fixed_string{"/a|/b"}>().view() ==
+              "");
+
+/** @brief Compile-time description of a route: method and literal prefix.
+ *
+ * Unknown handler types are tried for any method and path.
+ */
+template <typename HandlerT> struct route_traits {
+  static constexpr bool any_method = true;
+  static constexpr http::method method{};
+  static constexpr literal_prefix<1> prefix{};
+};
+
+template <auto pattern, typename HandlerT>
+struct route_traits<g6::router::detail::handler<pattern, HandlerT>> {
+  static constexpr bool any_method = true;
+  static constexpr http::method method{};
+  static constexpr auto prefix = make_literal_prefix<pattern>();
+};
+
+template <auto pattern, http::method method_, typename HandlerT>
+struct route_traits<handler<pattern, method_, HandlerT>> {
+  static constexpr bool any_method = false;
+  static constexpr http::method method = method_;
+  static constexpr auto prefix = make_literal_prefix<pattern>();
+
+  static bool matches(std::string_view path) noexcept {
+    return bool(ctre::match<pattern>(path));
+  }
+};
+
+struct route_info {
+  std::string_view prefix;
+  bool exact;
+  bool any_method;
+  http::method method;
+  // full pattern match (method specific routes only)
+  bool (*matches)(std::string_view path) noexcept;
+
+  [[nodiscard]] constexpr bool prefix_matches(std::string_view path) const noexcept {
+    return exact ? path == prefix : path.starts_with(prefix);
+  }
+};
+
+template <typename HandlerT> constexpr auto route_matcher() noexcept {
+  if constexpr (route_traits<HandlerT>::any_method) {
+    return static_cast<bool (*)(std::string_view) noexcept>(nullptr);
+  } else {
+    return &route_traits<HandlerT>::matches;
+  }
+}
+
+using method_set = std::bitset<method_count>;
+
+// Allow header value, HEAD is implied by GET and OPTIONS is always allowed
+inline std::string allow_header(method_set methods) {
+  if (methods.test(size_t(http::method::get))) {
+    methods.set(size_t(http::method::head));
+  }
+  methods.set(size_t(http::method::options));
+  std::string value;
+  for (size_t method = 0; method < method_count; ++method) {
+    if (methods.test(method)) {
+      if (not value.empty()) {
+        value += ", ";
+      }
+      value += http::detail::http_method_str(http::detail::http_method(method));
+    }
+  }
+  return value;
+}
+
+// first path segment ("/api/users" -> "api"), nullopt when not known from a literal prefix
+constexpr std::optional<std::string_view>
+first_segment(std::string_view path, bool complete) noexcept {
+  if (not path.starts_with('/')) {
+    return {};
+  }
+  auto end = path.find('/', 1);
+  if (end == std::string_view::npos) {
+    if (not complete) {
+      return {};
+    }
+    end = path.size();
+  }
+  return path.substr(1, end - 1);
+}
+
+/** @brief Candidate routes per method and first path segment.
+ *
+ * Indices are kept in declaration order so that the first matching route
+ * wins, as with g6::router::router.
+ */
+class dispatch_table {
+public:
+  template <size_t route_count>
+  explicit dispatch_table(std::array<route_info, route_count> const &routes) {
+    for (size_t method = 0; method < method_count; ++method) {
+      auto &table = methods_[method];
+      auto accepts = [&](route_info const &route) {
+        return route.any_method or size_t(route.method) == method;
+      };
+      for (size_t index = 0; index < route_count; ++index) {
+        auto const &route = routes[index];
+        if (not accepts(route)) {
+          continue;
+        }
+        if (auto segment = first_segment(route.prefix, route.exact)) {
+          if (std::none_of(table.segments.begin(), table.segments.end(),
+                           [&](auto const &s) { return s.first == *segment; })) {
+            table.segments.emplace_back(*segment, std::vector<size_t>{});
+          }
+        }
+      }
+      std::sort(table.segments.begin(), table.segments.end());
+      for (size_t index = 0; index < route_count; ++index) {
+        auto const &route = routes[index];
+        if (not accepts(route)) {
+          continue;
+        }
+        auto segment = first_segment(route.prefix, route.exact);
+        if (not segment) {
+          table.others.push_back(index);
+        }
+        for (auto &[name, candidates] : table.segments) {
+          if (not segment or *segment == name) {
+            candidates.push_back(index);
+          }
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] std::vector<size_t> const &
+  candidates(http::method method, std::string_view path) const noexcept {
+    auto const &table = methods_[size_t(method)];
+    if (auto segment = first_segment(path, true); segment) {
+      auto it = std::lower_bound(
+          table.segments.begin(), table.segments.end(), *segment,
+          [](auto const &s, std::string_view name) { return s.first < name; });
+      if (it != table.segments.end() and it->first == *segment) {
+        return it->second;
+      }
+    }
+    return table.others;
+  }
+
+private:
+  struct method_table {
+    // routes whose pattern starts with "/<segment>/" (or is exactly "/<segment>"),
+    // merged with the other routes
+    std::vector<std::pair<std::string_view, std::vector<size_t>>> segments;
+    // routes without a literal first segment
+    std::vector<size_t> others;
+  };
+  std::array<method_table, method_count> methods_;
+};
 } // namespace detail
 
+/** @brief HTTP router dispatching on method and first path segment.
+ *
+ * Same usage as g6::router::router, with the request method as first argument.
+ * Route literal prefixes are extracted from the patterns at compile time: a
+ * request only tries the routes declared for its method whose literal prefix
+ * matches the path, regex matching is only done for these candidates.
+ *
+ * @code
+ * auto router = http::route::router{
+ *     std::make_tuple(),
+ *     http::route::get<R"(/api/users/(\d+))">(...),
+ *     router::on<R"(.*)">(...)};
+ * co_await router(request.url(), request.method(), std::ref(session), std::ref(request));
+ * @endcode
+ */
+template <typename ContextT, typename... HandlersT> class router {
+public:
+  using result_t = std::common_type_t<typename HandlersT::result_t...>;
+
+  router(ContextT context, HandlersT... handlers)
+      : context_{std::move(context)}, handlers_{std::move(handlers)...} {}
+
+  /** @brief Invoke the first route matching @a path and @a method.
+   *
+   * @throws std::system_error (no_such_file_or_directory) when no route matches.
+   */
+  template <typename... ArgsT>
+  result_t operator()(std::string_view path, http::method method,
+                      ArgsT &&...args) {
+    auto route_args = std::make_tuple(method, std::forward<ArgsT>(args)...);
+    for (size_t index : table_.candidates(method, path)) {
+      if (not routes_[index].prefix_matches(path)) {
+        continue;
+      }
+      if (auto result = invoke(index, path, route_args)) {
+        return std::move(*result);
+      }
+    }
+    throw_no_route();
+  }
+
+  /** @brief Methods of the method-specific routes matching @a path.
+   *
+   * "*" (OPTIONS * request) is matched by all routes.
+   */
+  [[nodiscard]] detail::method_set
+  allowed_methods(std::string_view path) const noexcept {
+    detail::method_set methods;
+    for (auto const &route : routes_) {
+      if (not route.any_method and not methods.test(size_t(route.method)) and
+          (path == "*" or (route.prefix_matches(path) and route.matches(path)))) {
+        methods.set(size_t(route.method));
+      }
+    }
+    return methods;
+  }
+
+  /** @brief Serve @a request on @a session.
+   *
+   * Route handlers get @a session, @a request and @a args as contexts.
+   * Method-specific routes are tried first, then:
+   * - HEAD requests are served by GET routes (the session does not send the body),
+   * - OPTIONS requests are answered with 204 and an Allow header,
+   *   405 (Method Not Allowed) is sent when the path only matches routes of other methods,
+   *   without calling any handler,
+   * - any-method routes (router::on) are tried last.
+   *
+   * @throws std::system_error (no_such_file_or_directory) when no route matches.
+   */
+  template <typename Socket, typename... ArgsT>
+  task<void> async_serve(server_session<Socket> &session,
+                         server_request<Socket> &request, ArgsT &&...args) {
+    std::string_view path = request.url();
+    const auto method = request.method();
+    auto route_args = std::make_tuple(method, std::ref(session),
+                                      std::ref(request),
+                                      std::forward<ArgsT>(args)...);
+    if (auto result = try_routes(method, path, route_args, false)) {
+      co_await std::move(*result);
+      co_return;
+    }
+    if (method == http::method::head) {
+      std::get<http::method>(route_args) = http::method::get;
+      if (auto result = try_routes(http::method::get, path, route_args, false)) {
+        co_await std::move(*result);
+        co_return;
+      }
+      std::get<http::method>(route_args) = method;
+    }
+    if (auto allowed = allowed_methods(path); allowed.any()) {
+      const auto status = method == http::method::options
+                              ? http::status::no_content
+                              : http::status::method_not_allowed;
+      co_await net::async_send(
+          session, status,
+          http::headers{{"Allow", detail::allow_header(allowed)}},
+          span{static_cast<std::byte const *>(nullptr), 0});
+      co_return;
+    }
+    if (auto result = try_routes(method, path, route_args, true)) {
+      co_await std::move(*result);
+      co_return;
+    }
+    throw_no_route();
+  }
+
+private:
+  [[noreturn]] static void throw_no_route() {
+    throw std::system_error{
+        std::make_error_code(std::errc::no_such_file_or_directory),
+        "no matching route"};
+  }
+
+  // first matching route among either method-specific or any-method routes
+  template <typename ArgsT>
+  std::optional<result_t> try_routes(http::method method, std::string_view path,
+                                     ArgsT &args, bool any_method) {
+    for (size_t index : table_.candidates(method, path)) {
+      auto const &route = routes_[index];
+      if (route.any_method != any_method or not route.prefix_matches(path)) {
+        continue;
+      }
+      if (auto result = invoke(index, path, args)) {
+        return result;
+      }
+    }
+    return {};
+  }
+
+  template <size_t index, typename ArgsT>
+  static std::optional<result_t> invoke_handler(router &self,
+                                                std::string_view path,
+                                                ArgsT &args) {
+    return std::get<index>(self.handlers_)(self.context_, path, args);
+  }
+
+  // jump table: route index -> handler
+  template <typename ArgsT>
+  std::optional<result_t> invoke(size_t index, std::string_view path,
+                                 ArgsT &args) {
+    static constexpr auto handlers =
+        []<size_t... indices>(std::index_sequence<indices...>) {
+          return std::array{&invoke_handler<indices, ArgsT>...};
+        }(std::index_sequence_for<HandlersT...>{});
+    return handlers[index](*this, path, args);
+  }
+
+  static constexpr std::array<detail::route_info, sizeof...(HandlersT)>
+      routes_{detail::route_info{
+          detail::route_traits<HandlersT>::prefix.view(),
+          detail::route_traits<HandlersT>::prefix.exact,
+          detail::route_traits<HandlersT>::any_method,
+          detail::route_traits<HandlersT>::method,
+          detail::route_matcher<HandlersT>()}...};
+
+  ContextT context_;
+  std::tuple<HandlersT...> handlers_;
+  detail::dispatch_table table_{routes_};
+};
+
+template <typename ContextT, typename... HandlersT>
+router(ContextT, HandlersT...) -> router<ContextT, HandlersT...>;
+
 #define XX(num, name, string) \
   template <ctll::fixed_string pattern, typename HandlerT> \
   constexpr auto name(HandlerT &&handler) noexcept { \
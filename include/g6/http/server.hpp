@@ -12,13 +12,21 @@
 #include <g6/web/web_cpo.hpp>
 
 #include <unifex/async_scope.hpp>
+#include <unifex/file_concepts.hpp>
 #include <unifex/just.hpp>
 #include <unifex/let.hpp>
 #include <unifex/repeat_effect_until.hpp>
+#include <unifex/scheduler_concepts.hpp>
+#include <unifex/scope_guard.hpp>
+#include <unifex/stop_when.hpp>
 #include <unifex/transform_done.hpp>
+#include <unifex/when_all.hpp>
 
 #include <spdlog/spdlog.h>
 
+#include <chrono>
+#include <exception>
+
 namespace g6 {
 
     namespace web {
@@ -28,16 +36,93 @@ namespace g6 {
         template<typename Context>
         auto tag_invoke(tag_t<g6::web::make_server>, Context &ctx, web::proto::https_ const &,
                         net::ip_endpoint endpoint, const auto &, const auto &);
+
+        template<typename Context>
+        auto tag_invoke(tag_t<g6::web::make_server>, Context &, web::proto::http_ const &, net::async_socket socket);
     }// namespace web
 
     namespace http {
 
+        // requests loop of serve_connection
+        template<typename Socket, typename RequestHandler, typename Scheduler>
+        task<void> serve_requests(server_session<Socket> &session, RequestHandler &request_handler,
+                                  server_options const &options, Scheduler sched) {
+            for (size_t count = 1;; ++count) {
+                std::optional<server_request<Socket>> request;
+                co_await transform_done(
+                    stop_when(net::async_recv(session)
+                                  | transform([&request](server_request<Socket> &&req) { request.emplace(std::move(req)); }),
+                              schedule_at(sched, now(sched) + options.idle_timeout)),
+                    [] { return just(); });
+                if (not request) {
+                    // idle timeout or stop requested
+                    co_return;
+                }
+                if (options.max_requests_per_connection != 0 and count >= options.max_requests_per_connection) {
+                    session.keep_alive(false);
+                }
+                co_await request_handler(std::move(*request));
+                co_await session.async_discard_body();
+                if (not session.keep_alive() or not session.has_pending_request()) { co_await session.async_flush(); }
+                if (not session.keep_alive()) { co_return; }
+            }
+        }
+
+        /** @brief Persistent HTTP connection loop.
+         *
+         * Serves requests until the client (or the handler) disables keep-alive, the idle timeout
+         * expires or the per-connection request limit is reached.
+         * Unread request bodies are drained before reading the next request (see server_session::async_discard_body).
+         * Pipelined requests are handled in order, their responses are buffered until no more request
+         * is pending (see server_session::pipeline_buffer_size).
+         */
+        template<typename Socket, typename RequestHandler, typename Scheduler>
+        task<void> serve_connection(server_session<Socket> &session, RequestHandler &request_handler,
+                                    server_options const &options, Scheduler sched) {
+            std::exception_ptr error{};
+            try {
+                co_await serve_requests(session, request_handler, options, sched);
+            } catch (...) { error = std::current_exception(); }
+            // responses buffered for pipelined requests are sent whatever ends the connection
+            // (idle timeout, partial or rejected next request, handler error)
+            if (error) {
+                try {
+                    co_await session.async_flush();
+                } catch (std::system_error const &) {}
+                std::rethrow_exception(error);
+            }
+            co_await session.async_flush();
+        }
+
+        /** @brief Upgraded connection loop.
+         *
+         * Sessions that keep themselves alive (eg.: websockets, see ws::connection::async_keepalive) run
+         * their keepalive beside the request handler.
+         */
+        template<typename Session, typename RequestHandler, typename Scheduler>
+        task<void> serve_connection(Session &session, RequestHandler &request_handler, server_options const &,
+                                    Scheduler sched) {
+            auto handle = [&]() -> task<void> {
+                auto request = co_await net::async_recv(session);
+                co_await request_handler(std::move(request));
+            };
+            if constexpr (requires { session.async_keepalive(sched); }) {
+                co_await when_all(session.async_keepalive(sched), [&]() -> task<void> {
+                    scope_guard stop = [&]() noexcept { session.stop_keepalive(); };
+                    co_await handle();
+                }());
+            } else {
+                co_await handle();
+            }
+        }
+
         template<typename Context, typename Socket>
         class server
         {
         protected:
             Context &context_;
             async_scope scope_{};
+            server_options options_{};
             server(Context &context, Socket socket) : context_{context}, socket{std::move(socket)} {}
 
         public:
@@ -45,6 +130,14 @@ namespace g6 {
 
             Socket socket;
 
+            auto &options() noexcept { return options_; }
+
+            /** @brief Wait for all connections to terminate.
+             *
+             * Spawned connections are requested to stop, the server context must still be running.
+             */
+            auto cleanup() noexcept { return scope_.cleanup(); }
+
             using connection_type = server_session<Socket>;
 
             server() = delete;
@@ -63,29 +156,48 @@ namespace g6 {
             friend auto g6::web::tag_invoke(tag_t<g6::web::make_server>, Context2 &ctx, web::proto::https_ const &,
                                             net::ip_endpoint, const auto &, const auto &);
 
+            template<typename Context2>
+            friend auto g6::web::tag_invoke(tag_t<g6::web::make_server>, Context2 &, web::proto::http_ const &,
+                                            net::async_socket socket);
+
             template<template<class, class> typename Server, typename Context_, typename Socket_,
                 typename RequestHandlerBuilder>
             friend task<void> tag_invoke(tag_t<web::async_serve>, Server<Context_, Socket_> &server,
                                   inplace_stop_source &stop_source, RequestHandlerBuilder &&request_handler_builder) {
 
                 async_scope &scope = server.scope_;
+                auto const &options = server.options_;
                 auto sched = server.context_.get_scheduler();
 
                 while (not stop_source.stop_requested()) {
                     auto [sock, address] = co_await with_query_value(net::async_accept(server.socket), get_stop_token,
                                                                      stop_source.get_token());
-                    auto http_session = server_session<Socket_>{std::move(sock), address};
+                    auto http_session = server_session<Socket_>{std::move(sock), address, server.options_};
+                    if constexpr (not web::detail::native_socket<Socket_>) {
+                        http_session.file_sender([sched](Socket_ &socket, int file_fd, off_t offset, size_t count,
+                                                         size_t chunk_size) -> task<size_t> {
+                            // new descriptor of the same file, read by the io context
+                            auto file = open_file_read_only(sched, fmt::format("/proc/self/fd/{}", file_fd));
+                            co_return co_await web::async_send_file(socket, file, offset, count, chunk_size);
+                        });
+                    }
                     spdlog::info("client connected: {}", address.to_string());
-                    auto session = co_await web::upgrade_connection(Server<Context_, Socket_>::proto, http_session);
+                    auto session = co_await [&] {
+                        if constexpr (requires { server.upgrade_options(); }) {
+                            return web::upgrade_connection(Server<Context_, Socket_>::proto, http_session,
+                                                           server.upgrade_options());
+                        } else {
+                            return web::upgrade_connection(Server<Context_, Socket_>::proto, http_session);
+                        }
+                    }();
                     scope.spawn(
                         with_query_value(
                             let(just(),// TODO why this let just ? (task does not have sends_done ?)
                                 [session = std::move(session), builder = std::forward<RequestHandlerBuilder>(
-                                    request_handler_builder)]() mutable -> task<void> {
+                                    request_handler_builder), &options, sched]() mutable -> task<void> {
                                   try {
                                       auto request_handler = builder(session);
-                                      auto request = co_await net::async_recv(session);
-                                      co_await request_handler(std::move(request));
+                                      co_await serve_connection(session, request_handler, options, sched);
                                   } catch (std::system_error const &error) {
                                       if (error.code() != std::errc::connection_reset) {
                                           spdlog::info("connection {} error '{}'", session.remote_endpoint().to_string(), error.code().message());
@@ -126,6 +238,12 @@ namespace g6 {
             auto socket = net::open_socket(ctx, ssl::tcp_server, std::move(endpoint), cert, key);
             return http::server{ctx, std::move(socket)};
         }
+
+        template<typename Context>
+        auto tag_invoke(tag_t<g6::web::make_server>, Context &ctx, web::proto::http_ const &,
+                        net::async_socket socket) {
+            return http::server{ctx, std::move(socket)};
+        }
     }// namespace web
 
 }// namespace g6
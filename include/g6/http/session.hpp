@@ -12,63 +12,133 @@
 #include <unifex/transform.hpp>
 #include <unifex/transform_done.hpp>
 
+#include <g6/http/chunked.hpp>
+#include <g6/http/file_body.hpp>
 #include <g6/http/impl/static_parser_handler.hpp>
 #include <g6/net/ip_endpoint.hpp>
 #include <g6/net/net_cpo.hpp>
+#include <g6/web/buffer.hpp>
+#include <g6/web/gather.hpp>
+#include <g6/web/sendfile.hpp>
 #include <g6/web/web_cpo.hpp>
 
+#include <bit>
+#include <chrono>
+#include <functional>
+
 namespace g6::http {
 
     template<typename Socket>
     struct server_response {
         Socket &socket_;
         bool closed_{false};
-        std::string size_str;
+        // HEAD request: chunks are accepted but not sent
+        bool discard_body_{false};
 
         template<typename T, size_t extent = unifex::dynamic_extent>
-        friend auto tag_invoke(unifex::tag_t<net::async_send>, server_response &stream, span<T, extent> data) {
+        friend task<size_t> tag_invoke(unifex::tag_t<net::async_send>, server_response &stream, span<T, extent> data) {
             assert(!stream.closed_);
-            constexpr auto discard = transform([](auto &&...) {});
-            stream.size_str = fmt::format("{:x}\r\n", data.size());
-
-            return sequence(
-                       net::async_send(stream.socket_, as_bytes(span{stream.size_str.data(), stream.size_str.size()}))
-                           | discard,
-                       net::async_send(stream.socket_, data) | discard,
-                       net::async_send(stream.socket_, as_bytes(span{"\r\n", 2})) | discard)
-                 | transform([bytes = data.size()](auto &&...) { return bytes; });
+            if (stream.discard_body_) { co_return data.size(); }
+            co_return co_await detail::async_send_chunk(stream.socket_, as_bytes(span{data.data(), data.size()}));
         }
 
-        friend auto tag_invoke(unifex::tag_t<net::async_send>, server_response &stream) {
+        friend task<void> tag_invoke(unifex::tag_t<net::async_send>, server_response &stream) {
             stream.closed_ = true;
-            return net::async_send(stream.socket_, as_bytes(span{"0\r\n\r\n", 5}));
+            if (not stream.discard_body_) { co_await detail::async_send_last_chunk(stream.socket_); }
         }
     };
 
-    using session_buffer = std::array<char, 1024>;
+    struct server_options {
+        // maximum number of requests served on a single connection (0 means unlimited)
+        size_t max_requests_per_connection = 1000;
+        // maximum time to wait for the next request on a kept-alive connection
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds{60};
+        // maximum size of responses buffered while pipelined requests are pending (0 disables buffering)
+        size_t pipeline_buffer_size = 16 * 1024;
+        // receive buffer sizes (buffer grows when filled up by a single receive), a max_size of 0 derives
+        // the limit from max_header_size: a whole request head plus a body receive of initial_size
+        web::buffer_options buffer{.max_size = 0};
+        // maximum size of request line and headers, larger requests are rejected with status 431
+        size_t max_header_size = 16 * 1024;
+        // size of file reads when file bodies cannot be sent with sendfile (eg.: TLS)
+        size_t file_chunk_size = 256 * 1024;
+        // maximum request body size, larger bodies are rejected with status 413 (0 means unlimited)
+        size_t max_body_size = 0;
+    };
+
+    inline const server_options default_server_options{};
 
     template<typename Socket>
-    struct server_request : detail::static_parser_handler<true> {
-        Socket &socket_;
-        session_buffer &buffer_;
-        server_request(Socket &socket, session_buffer &buffer) noexcept : socket_{socket}, buffer_{buffer} {}
+    class server_session;
+
+    namespace detail {
+        struct request_parser : static_parser_handler<true> {
+            request_parser() = default;
+            request_parser(request_parser &&) noexcept = default;
+
+            using static_parser_handler<true>::header_done;
+            using static_parser_handler<true>::has_body;
+            using static_parser_handler<true>::body;
+            using static_parser_handler<true>::content_length;
+            using static_parser_handler<true>::detach_headers;
+        };
+    }// namespace detail
+
+    /** @brief Current request of a server_session.
+     *
+     * Parsing state is owned by the session, so that the session can drain
+     * any unread body once the request handler is done with it.
+     */
+    template<typename Socket>
+    class server_request
+    {
+        server_session<Socket> *session_;
 
-        server_request(server_request &&other) noexcept
-            : detail::static_parser_handler<true>{std::forward<server_request>(other)}, socket_{other.socket_},
-              buffer_{other.buffer_} {};
+        auto &parser() const noexcept { return session_->parser_; }
+        auto async_parse_some() { return session_->async_parse_some(); }
 
+        task<span<std::byte const>> async_recv_body() {
+            auto &session = *session_;
+            auto &parser = session.parser_;
+            if (session.continue_pending_) { co_await session.async_send_continue(); }
+            while (not parser.has_body() and net::has_pending_data(parser)) { co_await session.async_parse_some(); }
+            auto body = parser.body();
+            session.body_size_ += body.size();
+            if (session.options_->max_body_size != 0 and session.body_size_ > session.options_->max_body_size) {
+                co_await session.async_reject(http::status::payload_too_large);
+            }
+            co_return body;
+        }
+
+    public:
+        explicit server_request(server_session<Socket> &session) noexcept : session_{&session} {}
+
+        server_request(server_request &&other) noexcept = default;
         server_request(server_request const &other) = delete;
 
+        auto method() const { return parser().method(); }
+        auto const &url() const { return parser().url(); }
+        std::string_view target() const noexcept { return parser().target(); }
+        web::uri uri() const noexcept { return parser().uri(); }
+        auto const &headers() const { return parser().headers(); }
+        auto header(auto const &key) const noexcept { return parser().header(key); }
+        auto header_at(auto const &key) const { return parser().header_at(key); }
+        [[nodiscard]] bool chunked() const { return parser().chunked(); }
+        [[nodiscard]] bool keep_alive() const noexcept { return parser().keep_alive(); }
+        [[nodiscard]] auto http_version() const noexcept { return parser().http_version(); }
+        std::string to_string() const { return parser().to_string(); }
+
+        friend bool tag_invoke(unifex::tag_t<net::has_pending_data>, server_request &request) noexcept {
+            return net::has_pending_data(request.parser());
+        }
+
+        /** @brief Receive the next body part.
+         *
+         * "100 Continue" is sent before the first receive when the client expects it.
+         * Bodies larger than server_options::max_body_size are rejected with status 413 (the connection is reset).
+         */
         friend task<span<std::byte const>> tag_invoke(unifex::tag_t<net::async_recv>, server_request &request) {
-            using namespace unifex;
-            if (request.has_body()) {
-                co_return request.body();
-            } else {
-                size_t bytes = co_await net::async_recv(request.socket_, as_writable_bytes(span{request.buffer_}));
-                if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
-                request.parse(as_bytes(span{request.buffer_.data(), bytes}));
-                co_return request.body();
-            }
+            return request.async_recv_body();
         }
     };
 
@@ -80,10 +150,159 @@ namespace g6::http {
 
         auto const &remote_endpoint() const noexcept { return endpoint_; }
 
+        [[nodiscard]] server_options const &options() const noexcept { return *options_; }
+
+        /** @brief Connection persistence.
+         *
+         * Initialized from the request (HTTP/1.1 defaults to keep-alive, HTTP/1.0 requires
+         * "Connection: keep-alive"), it can be disabled to close the connection once the current
+         * response is sent.
+         */
+        [[nodiscard]] bool keep_alive() const noexcept { return keep_alive_; }
+        void keep_alive(bool value) noexcept { keep_alive_ = value; }
+
+        /** @brief Pipelined request availability.
+         *
+         * @return true when the bytes already received contain (the beginning of) a next request.
+         */
+        [[nodiscard]] bool has_pending_request() noexcept {
+            return not pending_.empty() and not net::has_pending_data(parser_);
+        }
+
+        /** @brief The client waits for "100 Continue" before sending the current request body.
+         *
+         * The interim response is sent on the first body receive: an unread body is never sent by the client.
+         */
+        [[nodiscard]] bool continue_pending() const noexcept { return continue_pending_; }
+
+        /** @brief The current request is a HEAD request.
+         *
+         * Responses are sent without their body (headers, including Content-Length, are kept),
+         * handlers might check it to avoid producing the body.
+         */
+        [[nodiscard]] bool head_request() const noexcept { return head_request_; }
+
+        /** @brief Discard the unread body of the current request.
+         *
+         * Keep-alive is disabled instead when the client still waits for "100 Continue" (the body will not be sent),
+         * or when the body exceeds server_options::max_body_size.
+         */
+        task<void> async_discard_body() {
+            if (continue_pending_) {
+                keep_alive_ = false;
+                co_return;
+            }
+            while (net::has_pending_data(parser_)) {
+                co_await async_parse_some();
+                body_size_ += parser_.body().size();
+                if (options_->max_body_size != 0 and body_size_ > options_->max_body_size) {
+                    keep_alive_ = false;
+                    co_return;
+                }
+            }
+        }
+
+        /** @brief File body sender for sockets that cannot use sendfile (TLS).
+         *
+         * Called with the socket, file descriptor, offset, size and server_options::file_chunk_size,
+         * the server installs one reading the file with the io context (async_read_some_at).
+         */
+        using file_sender_type = std::function<task<size_t>(Socket &, int, off_t, size_t, size_t)>;
+
+        void file_sender(file_sender_type sender) noexcept { file_sender_ = std::move(sender); }
+
+        /** @brief Send @a count bytes of the file @a file_fd starting at @a offset.
+         */
+        task<size_t> async_send_file(int file_fd, off_t offset, size_t count) {
+            if (file_sender_) {
+                co_return co_await file_sender_(socket, file_fd, offset, count, options_->file_chunk_size);
+            }
+            co_return co_await web::async_send_file(socket, file_fd, offset, count, options_->file_chunk_size);
+        }
+
+        /** @brief Send buffered responses.
+         */
+        task<void> async_flush() {
+            if (not output_.empty()) {
+                co_await net::async_send(socket, as_bytes(span{output_.data(), output_.size()}));
+                output_.clear();
+            }
+        }
+
     protected:
         net::ip_endpoint endpoint_;
-        session_buffer buffer_;
+        server_options const *options_;
+        web::receive_buffer buffer_;
+        // received bytes not consumed by the parser yet
+        span<std::byte const> pending_{};
         std::string header_data_;
+        // responses buffered while pipelined requests are pending
+        std::string output_;
+        detail::request_parser parser_;
+        bool keep_alive_{true};
+        // current request body bytes received
+        size_t body_size_{0};
+        bool continue_pending_{false};
+        bool head_request_{false};
+        file_sender_type file_sender_;
+
+        friend class server_request<Socket>;
+
+        // feeds the parser with pending bytes, or with newly received ones when nothing is pending
+        task<size_t> async_parse_some() {
+            if (pending_.empty()) {
+                if (net::has_pending_data(parser_)) {
+                    // current request headers must outlive the buffer reuse
+                    parser_.detach_headers();
+                }
+                // buffered responses must not wait for the (maybe partial) next request
+                co_await async_flush();
+                auto buffer = buffer_.prepare();
+                size_t bytes = co_await net::async_recv(socket, buffer);
+                if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
+                buffer_.commit(bytes);
+                pending_ = as_bytes(buffer.first(bytes));
+            }
+            size_t consumed = parser_.parse(pending_);
+            pending_ = pending_.subspan(consumed);
+            co_return consumed;
+        }
+
+        task<void> async_send_continue() {
+            continue_pending_ = false;
+            // buffered responses of previous requests go first
+            static constexpr std::string_view interim = "HTTP/1.1 100 Continue\r\n\r\n";
+            co_await web::async_gather_send(socket, output_bytes(), as_bytes(span{interim.data(), interim.size()}));
+            output_.clear();
+        }
+
+        // sends an error response and resets the connection
+        task<void> async_reject(http::status status) {
+            keep_alive_ = false;
+            continue_pending_ = false;
+            co_await net::async_send(*this, status);
+            throw std::system_error{std::make_error_code(std::errc::connection_reset)};
+        }
+
+        static web::buffer_options receive_buffer_options(server_options const &options) noexcept {
+            auto buffer = options.buffer;
+            if (buffer.max_size == 0) { buffer.max_size = std::bit_ceil(options.max_header_size + buffer.initial_size); }
+            return buffer;
+        }
+
+        span<std::byte const> output_bytes() const noexcept { return as_bytes(span{output_.data(), output_.size()}); }
+        span<std::byte const> header_bytes() const noexcept {
+            return as_bytes(span{header_data_.data(), header_data_.size()});
+        }
+
+        bool should_buffer(http::status status, size_t size) noexcept {
+            return keep_alive_ and has_body(status) and has_pending_request()
+               and output_.size() + header_data_.size() + size <= options_->pipeline_buffer_size;
+        }
+
+        static bool has_body(http::status status) noexcept {
+            return int(status) >= 200 and status != http::status::no_content and status != http::status::not_modified;
+        }
 
         void build_header(http::status status, http::headers &&headers) noexcept {
             header_data_ = fmt::format("HTTP/1.1 {} {}\r\n"
@@ -92,12 +311,25 @@ namespace g6::http {
                                        detail::http_status_str(static_cast<detail::http_status>(status)));
 
             for (auto &[field, value] : headers) { header_data_ += fmt::format("{}: {}\r\n", field, value); }
+            if (not headers.contains("Connection")) { header_data_ += connection_header(); }
             header_data_ += "\r\n";
         }
 
+        // Connection header required by current persistence state
+        std::string_view connection_header() const noexcept {
+            if (not keep_alive_) {
+                return "Connection: close\r\n";
+            } else if (parser_.http_version() < std::pair{1, 1}) {
+                return "Connection: keep-alive\r\n";
+            }
+            return {};
+        }
+
     public:
-        server_session(Socket socket, net::ip_endpoint endpoint) noexcept
-            : socket{std::move(socket)}, endpoint_{std::move(endpoint)} {}
+        server_session(Socket socket, net::ip_endpoint endpoint,
+                       server_options const &options = default_server_options) noexcept
+            : socket{std::move(socket)}, endpoint_{std::move(endpoint)}, options_{&options},
+              buffer_{receive_buffer_options(options)} {}
 
         friend auto &tag_invoke(unifex::tag_t<web::get_socket>, server_session &session) noexcept {
             return session.socket;
@@ -105,24 +337,49 @@ namespace g6::http {
 
         friend task<server_request<Socket>> tag_invoke(unifex::tag_t<net::async_recv>, server_session &session) {
             using namespace unifex;
-            size_t bytes = co_await net::async_recv(session.socket, as_writable_bytes(span{session.buffer_}));
-            if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
-            server_request req{session.socket, session.buffer_};
-            req.parse(as_bytes(span{session.buffer_.data(), bytes}));
-            co_return req;
+            if (session.pending_.empty()) {
+                // connection is idle: release grown buffer
+                session.buffer_.shrink();
+            }
+            size_t header_size = 0;
+            do {
+                if (header_size > session.options_->max_header_size) {
+                    co_await session.async_reject(http::status::request_header_fields_too_large);
+                }
+                header_size += co_await session.async_parse_some();
+            } while (not session.parser_.header_done());
+            auto &parser = session.parser_;
+            session.keep_alive_ = parser.keep_alive();
+            session.body_size_ = 0;
+            session.head_request_ = parser.method() == http::method::head;
+            session.continue_pending_ = net::has_pending_data(parser) and parser.http_version() >= std::pair{1, 1}
+                                    and detail::iequals(parser.header(header_id::expect), "100-continue");
+            if (auto length = parser.content_length(); session.options_->max_body_size != 0 and length
+                                                       and *length > session.options_->max_body_size) {
+                co_await session.async_reject(http::status::payload_too_large);
+            }
+            co_return server_request<Socket>{session};
         }
 
         template<typename T, size_t extent = unifex::dynamic_extent>
-        friend auto tag_invoke(unifex::tag_t<net::async_send>, server_session &session, http::status status,
-                               http::headers &&hdrs, unifex::span<T, extent> data) {
+        friend task<size_t> tag_invoke(unifex::tag_t<net::async_send>, server_session &session, http::status status,
+                                       http::headers &&hdrs, unifex::span<T, extent> data) {
             using namespace unifex;
-            if (data.size()) { hdrs.template emplace("Content-Length", std::to_string(data.size())); }
+            auto body = as_bytes(span{data.data(), data.size()});
+            if (has_body(status) and not hdrs.contains("Content-Length")) {
+                hdrs.template emplace("Content-Length", std::to_string(body.size()));
+            }
+            if (session.head_request_) { body = {}; }
             session.build_header(status, std::move(hdrs));
-            return let(net::async_send(session.socket,
-                                       as_bytes(span{session.header_data_.data(), session.header_data_.size()})),
-                       [data, &session](size_t) {
-                           return net::async_send(session.socket, as_bytes(span{data.data(), data.size()}));
-                       });
+            if (session.should_buffer(status, body.size())) {
+                session.output_ += session.header_data_;
+                session.output_.append(reinterpret_cast<char const *>(body.data()), body.size());
+                co_return body.size();
+            }
+            // buffered responses, header and body in a single write
+            co_await web::async_gather_send(session.socket, session.output_bytes(), session.header_bytes(), body);
+            session.output_.clear();
+            co_return body.size();
         }
 
         template<typename T, size_t extent = unifex::dynamic_extent>
@@ -138,17 +395,54 @@ namespace g6::http {
             return tag_invoke(tag, session, status, http::headers{}, span{static_cast<const std::byte *>(nullptr), 0});
         }
 
-        friend auto tag_invoke(unifex::tag_t<net::async_send>, server_session &session, http::status status,
-                               http::headers &&headers) {
+        /** @brief Send a file body.
+         *
+         * Content-Length is set from the file body size.
+         */
+        friend task<size_t> tag_invoke(unifex::tag_t<net::async_send>, server_session &session, http::status status,
+                                       http::headers &&hdrs, http::file_body const &file) {
+            using namespace unifex;
+            hdrs.erase("Content-Length");
+            hdrs.emplace("Content-Length", std::to_string(file.size()));
+            session.build_header(status, std::move(hdrs));
+            co_await web::async_gather_send(session.socket, session.output_bytes(), session.header_bytes());
+            session.output_.clear();
+            if (session.head_request_) { co_return 0; }
+            co_return co_await session.async_send_file(file.native_handle(), file.offset(), file.size());
+        }
+
+        /** @brief Send a pre-serialized response.
+         *
+         * @param head Status line and headers, without the terminating empty line
+         *             (Connection header is added when required).
+         * @param body Body, matching the Content-Length of @a head (not sent for HEAD requests).
+         */
+        task<size_t> async_send_serialized(span<std::byte const> head, span<std::byte const> body) {
+            if (head_request_) { body = {}; }
+            auto connection = connection_header();
+            co_await web::async_gather_send(socket, output_bytes(), head,
+                                            as_bytes(span{connection.data(), connection.size()}),
+                                            as_bytes(span{"\r\n", 2}), body);
+            output_.clear();
+            co_return body.size();
+        }
+
+        friend task<server_response<Socket>> tag_invoke(unifex::tag_t<net::async_send>, server_session &session,
+                                                        http::status status, http::headers &&headers) {
             using namespace unifex;
+            if (not session.head_request_ and not headers.contains("Content-Length")
+                and not headers.contains("Transfer-Encoding")) {
+                // body is delimited by connection close
+                session.keep_alive_ = false;
+            }
             session.build_header(status, std::forward<http::headers>(headers));
-            return net::async_send(session.socket,
-                                   as_bytes(span{session.header_data_.data(), session.header_data_.size()}))
-                 | transform([&session](size_t) { return server_response{session.socket}; });
+            co_await web::async_gather_send(session.socket, session.output_bytes(), session.header_bytes());
+            session.output_.clear();
+            co_return server_response<Socket>{session.socket, false, session.head_request_};
         }
 
-        server_session(server_session &&other) noexcept
-            : socket{std::move(other.socket)}, endpoint_{std::move(other.endpoint_)} {}
+        // pending_ refers to the buffer slab, which is moved along
+        server_session(server_session &&other) noexcept = default;
         server_session(server_session const &other) = delete;
     };
 
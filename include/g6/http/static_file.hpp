@@ -0,0 +1,278 @@
+#pragma once
+
+#include <g6/http/content_encoding.hpp>
+#include <g6/http/file_body.hpp>
+#include <g6/http/header_map.hpp>
+#include <g6/http/http.hpp>
+#include <g6/http/session.hpp>
+
+#include <g6/web/gather.hpp>
+#include <g6/web/sendfile.hpp>
+
+#include <unifex/task.hpp>
+
+#include <fmt/format.h>
+
+#include <charconv>
+#include <ctime>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace g6::http {
+
+    /** @brief Format @a time as an HTTP date (IMF-fixdate, eg.: "Sun, 06 Nov 1994 08:49:37 GMT").
+     */
+    inline std::string format_http_date(std::time_t time) {
+        std::tm tm{};
+        ::gmtime_r(&time, &tm);
+        char out[32]{};
+        size_t size = std::strftime(out, sizeof(out), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return {out, size};
+    }
+
+    inline std::optional<std::time_t> parse_http_date(std::string_view date) {
+        std::string str{date};
+        std::tm tm{};
+        char const *end = ::strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        if (end == nullptr or *end != '\0') { return {}; }
+        return ::timegm(&tm);
+    }
+
+    /** @brief Strong entity tag built from inode, size and modification time.
+     */
+    inline std::string make_etag(struct stat const &status) {
+        auto mtime_ns = uint64_t(status.st_mtim.tv_sec) * 1'000'000'000u + uint64_t(status.st_mtim.tv_nsec);
+        return fmt::format("\"{:x}-{:x}-{:x}\"", status.st_ino, status.st_size, mtime_ns);
+    }
+
+    /** @brief Content type from the file extension (application/octet-stream when unknown).
+     */
+    inline std::string_view mime_type(std::filesystem::path const &path) noexcept {
+        static constexpr std::pair<std::string_view, std::string_view> types[] = {
+            {".html", "text/html; charset=utf-8"},
+            {".htm", "text/html; charset=utf-8"},
+            {".css", "text/css; charset=utf-8"},
+            {".js", "text/javascript; charset=utf-8"},
+            {".mjs", "text/javascript; charset=utf-8"},
+            {".json", "application/json"},
+            {".txt", "text/plain; charset=utf-8"},
+            {".xml", "application/xml"},
+            {".svg", "image/svg+xml"},
+            {".png", "image/png"},
+            {".jpg", "image/jpeg"},
+            {".jpeg", "image/jpeg"},
+            {".gif", "image/gif"},
+            {".webp", "image/webp"},
+            {".ico", "image/x-icon"},
+            {".wasm", "application/wasm"},
+            {".pdf", "application/pdf"},
+            {".zip", "application/zip"},
+            {".gz", "application/gzip"},
+            {".mp4", "video/mp4"},
+            {".woff2", "font/woff2"},
+        };
+        auto const &extension = path.extension().native();
+        for (auto const &[ext, type] : types) {
+            if (detail::iequals(ext, extension)) { return type; }
+        }
+        return "application/octet-stream";
+    }
+
+    struct byte_range {
+        size_t first;
+        // inclusive
+        size_t last;
+
+        [[nodiscard]] size_t size() const noexcept { return last - first + 1; }
+    };
+
+    /** @brief Parse a Range header value against a representation of @a size bytes.
+     *
+     * @return nullopt when the header is invalid (or has more than @a max_ranges ranges) and must be ignored,
+     *         an empty list when no range is satisfiable.
+     */
+    inline std::optional<std::vector<byte_range>> parse_range(std::string_view value, size_t size,
+                                                              size_t max_ranges = 16) {
+        constexpr std::string_view unit = "bytes=";
+        if (not value.starts_with(unit)) { return {}; }
+        value.remove_prefix(unit.size());
+        std::vector<byte_range> ranges;
+        size_t count = 0;
+        auto parse_number = [](std::string_view str) -> std::optional<size_t> {
+            size_t number = 0;
+            auto [ptr, error] = std::from_chars(str.data(), str.data() + str.size(), number);
+            if (str.empty() or error != std::errc{} or ptr != str.data() + str.size()) { return {}; }
+            return number;
+        };
+        while (not value.empty()) {
+            auto separator = value.find(',');
+            auto spec = value.substr(0, separator);
+            value = separator == std::string_view::npos ? std::string_view{} : value.substr(separator + 1);
+            spec.remove_prefix(std::min(spec.find_first_not_of(" \t"), spec.size()));
+            spec.remove_suffix(spec.size() - std::min(spec.find_last_not_of(" \t") + 1, spec.size()));
+            if (spec.empty()) { continue; }
+            if (++count > max_ranges) { return {}; }
+            auto dash = spec.find('-');
+            if (dash == std::string_view::npos) { return {}; }
+            if (dash == 0) {
+                // suffix range: last N bytes
+                auto suffix = parse_number(spec.substr(1));
+                if (not suffix) { return {}; }
+                if (*suffix and size) { ranges.push_back({size - std::min(*suffix, size), size - 1}); }
+                continue;
+            }
+            auto first = parse_number(spec.substr(0, dash));
+            // open range: up to the end
+            auto last = dash + 1 == spec.size() ? std::optional{std::numeric_limits<size_t>::max()}
+                                                : parse_number(spec.substr(dash + 1));
+            if (not first or not last or *last < *first) { return {}; }
+            if (*first < size) { ranges.push_back({*first, std::min(*last, size - 1)}); }
+        }
+        if (count == 0) { return {}; }
+        return ranges;
+    }
+
+    namespace detail {
+        // If-None-Match: comma-separated entity tags (weak comparison) or "*"
+        inline bool etag_matches(std::string_view value, std::string_view etag) noexcept {
+            while (not value.empty()) {
+                auto first = value.find_first_not_of(" \t,");
+                if (first == std::string_view::npos) { break; }
+                value.remove_prefix(first);
+                if (value.starts_with('*')) { return true; }
+                if (value.starts_with("W/")) { value.remove_prefix(2); }
+                auto end = value.find('"', 1);
+                if (not value.starts_with('"') or end == std::string_view::npos) { break; }
+                if (value.substr(0, end + 1) == etag) { return true; }
+                value.remove_prefix(end + 1);
+            }
+            return false;
+        }
+
+        inline std::string make_boundary() {
+            thread_local std::mt19937_64 generator{std::random_device{}()};
+            return fmt::format("g6-{:016x}", generator());
+        }
+    }// namespace detail
+
+    /** @brief Respond to @a request with the file at @a path.
+     *
+     * - ETag (inode, size, mtime) and Last-Modified headers are sent,
+     *   If-None-Match and If-Modified-Since are answered with 304 (Not Modified) for GET and HEAD requests,
+     * - single and multiple byte ranges (Range, If-Range) are answered with 206 (Partial Content),
+     *   unsatisfiable ones with 416 (Range Not Satisfiable),
+     * - precompressed siblings ("file.br", "file.gz") are sent when accepted (Accept-Encoding).
+     *
+     * @throws std::system_error when the file cannot be opened.
+     */
+    template<typename Socket>
+    task<void> async_send_static_file(server_session<Socket> &session, server_request<Socket> const &request,
+                                      std::filesystem::path const &path) {
+        const auto content_type = mime_type(path);
+        const bool compressible = is_compressible(content_type);
+        auto coding = content_coding::identity;
+        auto open = [&] {
+            if (auto accept_encoding = request.header(header_id::accept_encoding);
+                compressible and not accept_encoding.empty()) {
+                if (auto precompressed = open_precompressed(path, accept_encoding)) {
+                    coding = precompressed->second;
+                    return std::move(precompressed->first);
+                }
+            }
+            return http::file_body{path};
+        };
+        http::file_body file = open();
+        auto const &status = file.status();
+        const auto etag = make_etag(status);
+        const auto last_modified = format_http_date(status.st_mtim.tv_sec);
+        const size_t size = file.file_size();
+        auto make_headers = [&] {
+            http::headers headers{{"ETag", etag}, {"Last-Modified", last_modified}, {"Accept-Ranges", "bytes"}};
+            if (compressible) { headers.emplace("Vary", "Accept-Encoding"); }
+            if (coding != content_coding::identity) { headers.emplace("Content-Encoding", to_string(coding)); }
+            return headers;
+        };
+
+        // conditional requests (only GET and HEAD are answered with 304)
+        const bool head = request.method() == http::method::head;
+        bool not_modified = false;
+        if (auto if_none_match = request.header(header_id::if_none_match); not if_none_match.empty()) {
+            not_modified = detail::etag_matches(if_none_match, etag);
+        } else if (auto since = parse_http_date(request.header(header_id::if_modified_since))) {
+            not_modified = status.st_mtim.tv_sec <= *since;
+        }
+        if (not_modified and (head or request.method() == http::method::get)) {
+            co_await net::async_send(session, http::status::not_modified, make_headers(),
+                                     span{static_cast<std::byte const *>(nullptr), 0});
+            co_return;
+        }
+
+        std::optional<std::vector<byte_range>> ranges;
+        if (auto range = request.header(header_id::range); not range.empty() and not head) {
+            auto if_range = request.header(header_id::if_range);
+            if (if_range.empty() or if_range == etag or if_range == last_modified) {
+                ranges = parse_range(range, size);
+            }
+        }
+
+        if (not ranges) {
+            auto headers = make_headers();
+            headers.emplace("Content-Type", content_type);
+            if (head) {
+                headers.emplace("Content-Length", std::to_string(size));
+                co_await net::async_send(session, http::status::ok, std::move(headers),
+                                         span{static_cast<std::byte const *>(nullptr), 0});
+            } else {
+                co_await net::async_send(session, http::status::ok, std::move(headers), file);
+            }
+        } else if (ranges->empty()) {
+            auto headers = make_headers();
+            headers.emplace("Content-Range", fmt::format("bytes */{}", size));
+            co_await net::async_send(session, http::status::range_not_satisfiable, std::move(headers),
+                                     span{static_cast<std::byte const *>(nullptr), 0});
+        } else if (ranges->size() == 1) {
+            auto const &range = ranges->front();
+            auto headers = make_headers();
+            headers.emplace("Content-Type", content_type);
+            headers.emplace("Content-Range", fmt::format("bytes {}-{}/{}", range.first, range.last, size));
+            file.range(off_t(range.first), range.size());
+            co_await net::async_send(session, http::status::partial_content, std::move(headers), file);
+        } else {
+            // multipart/byteranges
+            const auto boundary = detail::make_boundary();
+            std::vector<std::string> part_headers;
+            part_headers.reserve(ranges->size() + 1);
+            size_t content_length = 0;
+            for (auto const &range : *ranges) {
+                part_headers.emplace_back(fmt::format("\r\n--{}\r\n"
+                                                      "Content-Type: {}\r\n"
+                                                      "Content-Range: bytes {}-{}/{}\r\n\r\n",
+                                                      boundary, content_type, range.first, range.last, size));
+                content_length += part_headers.back().size() + range.size();
+            }
+            part_headers.emplace_back(fmt::format("\r\n--{}--\r\n", boundary));
+            content_length += part_headers.back().size();
+
+            auto headers = make_headers();
+            headers.emplace("Content-Type", fmt::format("multipart/byteranges; boundary={}", boundary));
+            headers.emplace("Content-Length", std::to_string(content_length));
+            co_await net::async_send(session, http::status::partial_content, std::move(headers),
+                                     span{static_cast<std::byte const *>(nullptr), 0});
+            co_await session.async_flush();
+            for (size_t ii = 0; ii < ranges->size(); ++ii) {
+                auto const &range = (*ranges)[ii];
+                co_await web::async_gather_send(session.socket,
+                                                as_bytes(span{part_headers[ii].data(), part_headers[ii].size()}));
+                co_await session.async_send_file(file.native_handle(), off_t(range.first), range.size());
+            }
+            co_await web::async_gather_send(session.socket,
+                                            as_bytes(span{part_headers.back().data(), part_headers.back().size()}));
+        }
+    }
+
+}// namespace g6::http
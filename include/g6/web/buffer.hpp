@@ -0,0 +1,180 @@
+#pragma once
+
+#include <unifex/span.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace g6::web {
+
+    /** @brief Slab pool for receive buffers.
+     *
+     * Slabs are power-of-two sized (from 256 bytes to 1 MiB) and recycled through per-size free lists.
+     * The pool is not thread-safe: each thread (so each io context) owns its own pool (see buffer_pool::local).
+     */
+    class buffer_pool
+    {
+    public:
+        static constexpr size_t min_slab_size = 256;
+        static constexpr size_t max_slab_size = 1024 * 1024;
+
+        struct stats {
+            // bytes currently handed out to buffers
+            size_t in_use_bytes = 0;
+            // bytes kept in free lists
+            size_t pooled_bytes = 0;
+            size_t in_use_slabs = 0;
+        };
+
+        explicit buffer_pool(size_t max_pooled_bytes = 16 * 1024 * 1024) noexcept
+            : max_pooled_bytes_{max_pooled_bytes} {}
+
+        buffer_pool(buffer_pool const &) = delete;
+        buffer_pool &operator=(buffer_pool const &) = delete;
+
+        ~buffer_pool() noexcept {
+            for (auto &slabs : free_) {
+                for (auto *slab : slabs) { ::operator delete(slab); }
+            }
+        }
+
+        static buffer_pool &local() noexcept {
+            thread_local buffer_pool pool{};
+            return pool;
+        }
+
+        static constexpr size_t slab_size(size_t size) noexcept {
+            return std::bit_ceil(std::clamp(size, min_slab_size, max_slab_size));
+        }
+
+        unifex::span<std::byte> acquire(size_t size) {
+            size = slab_size(size);
+            auto &slabs = free_[index(size)];
+            std::byte *slab = nullptr;
+            if (slabs.empty()) {
+                slab = static_cast<std::byte *>(::operator new(size));
+            } else {
+                slab = slabs.back();
+                slabs.pop_back();
+                stats_.pooled_bytes -= size;
+            }
+            stats_.in_use_bytes += size;
+            ++stats_.in_use_slabs;
+            return {slab, size};
+        }
+
+        void release(unifex::span<std::byte> slab) noexcept {
+            stats_.in_use_bytes -= slab.size();
+            --stats_.in_use_slabs;
+            if (stats_.pooled_bytes + slab.size() > max_pooled_bytes_) {
+                ::operator delete(slab.data());
+                return;
+            }
+            try {
+                free_[index(slab.size())].push_back(slab.data());
+                stats_.pooled_bytes += slab.size();
+            } catch (std::bad_alloc const &) { ::operator delete(slab.data()); }
+        }
+
+        [[nodiscard]] stats const &statistics() const noexcept { return stats_; }
+
+    private:
+        static constexpr size_t index(size_t slab_size) noexcept {
+            return std::countr_zero(slab_size) - std::countr_zero(min_slab_size);
+        }
+
+        std::array<std::vector<std::byte *>, std::countr_zero(max_slab_size) - std::countr_zero(min_slab_size) + 1>
+            free_{};
+        size_t max_pooled_bytes_;
+        stats stats_{};
+    };
+
+    struct buffer_options {
+        size_t initial_size = 1024;
+        size_t max_size = 64 * 1024;
+    };
+
+    /** @brief Growable receive buffer backed by pooled slabs.
+     *
+     * The buffer doubles (up to buffer_options::max_size) when a receive filled it up,
+     * and can be shrunk back to its initial size when the connection goes idle.
+     */
+    class receive_buffer
+    {
+    public:
+        explicit receive_buffer(buffer_options options = {}, buffer_pool &pool = buffer_pool::local()) noexcept
+            : pool_{&pool}, options_{options} {}
+
+        receive_buffer(receive_buffer &&other) noexcept
+            : pool_{other.pool_}, options_{other.options_}, slab_{std::exchange(other.slab_, {})},
+              grow_{other.grow_}, prepared_{other.prepared_} {}
+
+        receive_buffer &operator=(receive_buffer &&other) noexcept {
+            release();
+            pool_ = other.pool_;
+            options_ = other.options_;
+            slab_ = std::exchange(other.slab_, {});
+            grow_ = other.grow_;
+            prepared_ = other.prepared_;
+            return *this;
+        }
+
+        receive_buffer(receive_buffer const &) = delete;
+        receive_buffer &operator=(receive_buffer const &) = delete;
+
+        ~receive_buffer() noexcept { release(); }
+
+        [[nodiscard]] unifex::span<std::byte> data() const noexcept { return slab_; }
+        [[nodiscard]] size_t size() const noexcept { return slab_.size(); }
+        [[nodiscard]] size_t max_size() const noexcept { return options_.max_size; }
+
+        /** @brief Get the storage for the next receive.
+         *
+         * @param preserved Number of leading bytes to keep (eg.: a partially received frame).
+         * @return Storage following the preserved bytes, empty when max_size has been reached.
+         */
+        unifex::span<std::byte> prepare(size_t preserved = 0) {
+            if (slab_.empty()) {
+                slab_ = pool_->acquire(options_.initial_size);
+            } else if ((grow_ or preserved == slab_.size()) and slab_.size() < options_.max_size) {
+                auto slab = pool_->acquire(slab_.size() * 2);
+                if (preserved) { std::memcpy(slab.data(), slab_.data(), preserved); }
+                pool_->release(std::exchange(slab_, slab));
+            }
+            grow_ = false;
+            prepared_ = slab_.size() - preserved;
+            return slab_.subspan(preserved);
+        }
+
+        /** @brief Notify the number of bytes received in the storage returned by prepare.
+         */
+        void commit(size_t bytes) noexcept { grow_ = bytes == prepared_; }
+
+        /** @brief Go back to initial size.
+         */
+        void shrink() noexcept {
+            if (slab_.size() > buffer_pool::slab_size(options_.initial_size)) { release(); }
+        }
+
+        /** @brief Give the storage back to the pool.
+         */
+        void release() noexcept {
+            if (not slab_.empty()) { pool_->release(std::exchange(slab_, {})); }
+            grow_ = false;
+        }
+
+    private:
+        buffer_pool *pool_;
+        buffer_options options_;
+        unifex::span<std::byte> slab_{};
+        bool grow_{false};
+        size_t prepared_{0};
+    };
+
+}// namespace g6::web
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <unifex/span.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace g6::web {
+
+    namespace detail {
+        inline std::error_code zlib_error_code(int result) noexcept {
+            switch (result) {
+                case Z_MEM_ERROR:
+                    return std::make_error_code(std::errc::not_enough_memory);
+                case Z_STREAM_ERROR:
+                    return std::make_error_code(std::errc::invalid_argument);
+                default:
+                    return std::make_error_code(std::errc::illegal_byte_sequence);
+            }
+        }
+    }// namespace detail
+
+    /** @brief zlib compression stream.
+     *
+     * @a window_bits selects the format: 8..15 for zlib (HTTP "deflate"), 16 + (8..15) for gzip,
+     * -8..-15 for raw deflate.
+     */
+    class deflater
+    {
+    public:
+        explicit deflater(int level = Z_DEFAULT_COMPRESSION, int window_bits = 15, int mem_level = 8)
+            : level_{level}, window_bits_{window_bits} {
+            auto stream = std::make_unique<z_stream>();
+            int result = ::deflateInit2(stream.get(), level, Z_DEFLATED, window_bits, mem_level, Z_DEFAULT_STRATEGY);
+            if (result != Z_OK) {
+                throw std::system_error{detail::zlib_error_code(result), "deflateInit2"};
+            }
+            stream_.reset(stream.release());
+        }
+
+        [[nodiscard]] int level() const noexcept { return level_; }
+        [[nodiscard]] int window_bits() const noexcept { return window_bits_; }
+
+        /** @brief Compress @a input.
+         *
+         * @param flush Z_NO_FLUSH (output might be empty), Z_SYNC_FLUSH (all input is output) or Z_FINISH.
+         * @return Compressed bytes, valid until the next call.
+         */
+        unifex::span<std::byte const> compress(unifex::span<std::byte const> input, int flush = Z_NO_FLUSH) {
+            stream_->next_in = reinterpret_cast<Bytef *>(const_cast<std::byte *>(input.data()));
+            stream_->avail_in = uInt(input.size());
+            if (output_.empty()) {
+                output_.resize(std::max<size_t>(::deflateBound(stream_.get(), uLong(input.size())), 1024));
+            }
+            size_t produced = 0;
+            int result = Z_OK;
+            do {
+                if (produced == output_.size()) { output_.resize(output_.size() * 2); }
+                stream_->next_out = reinterpret_cast<Bytef *>(output_.data() + produced);
+                stream_->avail_out = uInt(output_.size() - produced);
+                result = ::deflate(stream_.get(), flush);
+                if (result == Z_STREAM_ERROR) { throw std::system_error{detail::zlib_error_code(result), "deflate"}; }
+                produced = output_.size() - stream_->avail_out;
+            } while (stream_->avail_out == 0 or (flush == Z_FINISH and result != Z_STREAM_END));
+            return {output_.data(), produced};
+        }
+
+        /** @brief Restart a new stream (keeps compression parameters).
+         */
+        void reset() noexcept { ::deflateReset(stream_.get()); }
+
+    private:
+        struct stream_delete {
+            void operator()(z_stream *stream) const noexcept {
+                ::deflateEnd(stream);
+                delete stream;
+            }
+        };
+        // zlib state points back to its stream: heap allocated to keep the deflater movable
+        int level_;
+        int window_bits_;
+        std::unique_ptr<z_stream, stream_delete> stream_;
+        std::vector<std::byte> output_;
+    };
+
+    /** @brief zlib decompression stream (see deflater for @a window_bits).
+     */
+    class inflater
+    {
+    public:
+        explicit inflater(int window_bits = 15) : window_bits_{window_bits} {
+            auto stream = std::make_unique<z_stream>();
+            int result = ::inflateInit2(stream.get(), window_bits);
+            if (result != Z_OK) { throw std::system_error{detail::zlib_error_code(result), "inflateInit2"}; }
+            stream_.reset(stream.release());
+        }
+
+        [[nodiscard]] int window_bits() const noexcept { return window_bits_; }
+
+        /** @brief Decompress the beginning of @a input, at most @a max_output bytes are produced.
+         *
+         * Consumed bytes are removed from @a input. When the output is full (see full), call again
+         * (even with an empty input) to get the remaining output.
+         *
+         * @return Decompressed bytes, valid until the next call.
+         */
+        unifex::span<std::byte> decompress(unifex::span<std::byte const> &input, size_t max_output) {
+            if (output_.size() < max_output) { output_.resize(max_output); }
+            stream_->next_in = reinterpret_cast<Bytef *>(const_cast<std::byte *>(input.data()));
+            stream_->avail_in = uInt(input.size());
+            stream_->next_out = reinterpret_cast<Bytef *>(output_.data());
+            stream_->avail_out = uInt(max_output);
+            int result = ::inflate(stream_.get(), Z_SYNC_FLUSH);
+            if (result != Z_OK and result != Z_STREAM_END and result != Z_BUF_ERROR) {
+                throw std::system_error{detail::zlib_error_code(result), "inflate"};
+            }
+            input = input.subspan(input.size() - stream_->avail_in);
+            const size_t produced = max_output - stream_->avail_out;
+            full_ = stream_->avail_out == 0;
+            // raw streams might be finished (final block): next bytes start a new one
+            if (result == Z_STREAM_END) { reset(); }
+            return {output_.data(), produced};
+        }
+
+        /** @brief Last decompress call filled its output (more output might be pending).
+         */
+        [[nodiscard]] bool full() const noexcept { return full_; }
+
+        void reset() noexcept {
+            ::inflateReset(stream_.get());
+            full_ = false;
+        }
+
+    private:
+        struct stream_delete {
+            void operator()(z_stream *stream) const noexcept {
+                ::inflateEnd(stream);
+                delete stream;
+            }
+        };
+        int window_bits_;
+        std::unique_ptr<z_stream, stream_delete> stream_;
+        std::vector<std::byte> output_;
+        bool full_{false};
+    };
+
+    /** @brief Recycles deflaters (zlib state is about 256 KiB, too expensive to initialize per response).
+     *
+     * The pool is not thread-safe: each thread owns its own pool (see deflater_pool::local).
+     */
+    class deflater_pool
+    {
+    public:
+        static constexpr size_t max_pooled_deflaters = 16;
+
+        struct recycle {
+            void operator()(deflater *d) const noexcept { local().release(d); }
+        };
+        using pointer = std::unique_ptr<deflater, recycle>;
+
+        deflater_pool() = default;
+        deflater_pool(deflater_pool const &) = delete;
+        deflater_pool &operator=(deflater_pool const &) = delete;
+
+        static deflater_pool &local() noexcept {
+            thread_local deflater_pool pool{};
+            return pool;
+        }
+
+        pointer acquire(int level, int window_bits) {
+            auto it = std::find_if(free_.begin(), free_.end(), [&](auto const &d) {
+                return d->level() == level and d->window_bits() == window_bits;
+            });
+            if (it == free_.end()) { return pointer{new deflater{level, window_bits}}; }
+            pointer d{it->release()};
+            free_.erase(it);
+            return d;
+        }
+
+    private:
+        void release(deflater *d) noexcept {
+            std::unique_ptr<deflater> owned{d};
+            if (free_.size() < max_pooled_deflaters) {
+                owned->reset();
+                try {
+                    free_.push_back(std::move(owned));
+                } catch (...) {}
+            }
+        }
+
+        std::vector<std::unique_ptr<deflater>> free_;
+    };
+
+}// namespace g6::web
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <g6/net/async_socket.hpp>
+#include <g6/net/net_cpo.hpp>
+
+#include <g6/web/buffer.hpp>
+
+#include <unifex/scope_guard.hpp>
+#include <unifex/span.hpp>
+#include <unifex/task.hpp>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <concepts>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace g6::web {
+
+    namespace detail {
+        // plain TCP sockets whose descriptor can be written directly (not TLS ones)
+        template<typename Socket>
+        concept native_socket = std::same_as<std::remove_cvref_t<Socket>, net::async_socket> and requires(Socket &s) {
+            { s.native_handle() } -> std::convertible_to<int>;
+        };
+
+        // buffers smaller than this are coalesced into a single send when gathering is not available
+        inline constexpr size_t max_coalesced_size = 16 * 1024;
+
+        template<typename Socket>
+        task<void> async_send_all(Socket &socket, span<std::byte const> data) {
+            while (not data.empty()) {
+                size_t bytes = co_await net::async_send(socket, data);
+                if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::connection_reset)}; }
+                data = data.subspan(bytes);
+            }
+        }
+
+        template<typename Socket, typename Buffers>
+        task<size_t> async_gather_send(Socket &socket, Buffers buffers) {
+            size_t total = 0;
+            for (auto const &buffer : buffers) { total += buffer.size(); }
+            size_t sent = 0;
+            if constexpr (native_socket<Socket>) {
+                // optimistic non-blocking write of all buffers at once,
+                // the remainder (socket buffer full) goes through the asynchronous path
+                std::conditional_t<std::is_same_v<Buffers, std::vector<span<std::byte const>>>, std::vector<iovec>,
+                                   std::array<iovec, std::tuple_size_v<Buffers>>>
+                    iov{};
+                if constexpr (requires { iov.resize(0); }) { iov.resize(buffers.size()); }
+                for (size_t ii = 0; ii < buffers.size(); ++ii) {
+                    iov[ii] = {const_cast<std::byte *>(buffers[ii].data()), buffers[ii].size()};
+                }
+                msghdr message{};
+                message.msg_iov = iov.data();
+                message.msg_iovlen = iov.size();
+                ssize_t result = ::sendmsg(socket.native_handle(), &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (result < 0 and errno != EAGAIN and errno != EWOULDBLOCK) {
+                    throw std::system_error{errno, std::system_category(), "sendmsg"};
+                }
+                sent = result < 0 ? 0 : size_t(result);
+            } else if (total <= max_coalesced_size) {
+                // TLS: a single record
+                auto &pool = buffer_pool::local();
+                auto storage = pool.acquire(total);
+                size_t offset = 0;
+                for (auto const &buffer : buffers) {
+                    if (not buffer.empty()) { std::memcpy(storage.data() + offset, buffer.data(), buffer.size()); }
+                    offset += buffer.size();
+                }
+                scope_guard release = [&]() noexcept { pool.release(storage); };
+                co_await async_send_all(socket, as_bytes(storage.first(total)));
+                co_return total;
+            }
+            for (auto buffer : buffers) {
+                if (sent >= buffer.size()) {
+                    sent -= buffer.size();
+                    continue;
+                }
+                co_await async_send_all(socket, buffer.subspan(sent));
+                sent = 0;
+            }
+            co_return total;
+        }
+    }// namespace detail
+
+    /** @brief Send several buffers at once.
+     *
+     * On plain TCP sockets, buffers are written with a single sendmsg when the socket buffer has room.
+     * Otherwise (or for TLS sockets), small buffers are coalesced into a single send.
+     *
+     * @return Total number of bytes sent.
+     */
+    template<typename Socket, std::convertible_to<span<std::byte const>>... Buffers>
+    auto async_gather_send(Socket &socket, Buffers const &...buffers) {
+        return detail::async_gather_send(
+            socket, std::array<span<std::byte const>, sizeof...(Buffers)>{span<std::byte const>{buffers}...});
+    }
+
+    template<typename Socket>
+    auto async_gather_send(Socket &socket, std::vector<span<std::byte const>> buffers) {
+        return detail::async_gather_send(socket, std::move(buffers));
+    }
+
+}// namespace g6::web
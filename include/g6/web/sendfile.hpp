@@ -0,0 +1,132 @@
+#pragma once
+
+#include <g6/web/buffer.hpp>
+#include <g6/web/gather.hpp>
+
+#include <unifex/file_concepts.hpp>
+#include <unifex/scope_guard.hpp>
+#include <unifex/span.hpp>
+#include <unifex/task.hpp>
+
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <system_error>
+#include <type_traits>
+
+namespace g6::web {
+
+    namespace detail {
+        // sendfile writes to the socket descriptor directly: it must not block the io context thread on a slow
+        // client. The socket is left non-blocking (asynchronous operations do not depend on the file status flags,
+        // other direct writes use MSG_DONTWAIT)
+        inline void set_non_blocking(int fd) {
+            const int flags = ::fcntl(fd, F_GETFL);
+            if (flags < 0) { throw std::system_error{errno, std::system_category(), "fcntl"}; }
+            if ((flags & O_NONBLOCK) == 0 and ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+                throw std::system_error{errno, std::system_category(), "fcntl"};
+            }
+        }
+
+        // sends as much of the file as the (non-blocking) socket accepts
+        inline size_t sendfile_some(int fd, int file_fd, off_t offset, size_t count) {
+            size_t sent = 0;
+            while (sent < count) {
+                ssize_t bytes = ::sendfile(fd, file_fd, &offset, count - sent);
+                if (bytes > 0) {
+                    sent += size_t(bytes);
+                } else if (bytes == 0) {
+                    throw std::system_error{std::make_error_code(std::errc::io_error), "truncated file"};
+                } else if (errno == EAGAIN or errno == EWOULDBLOCK) {
+                    break;
+                } else if (errno != EINTR) {
+                    throw std::system_error{errno, std::system_category(), "sendfile"};
+                }
+            }
+            return sent;
+        }
+
+        // waits for room in the socket send buffer by sending the next file byte asynchronously
+        // (a zero-length send completes at once, whatever the room)
+        template<typename Socket>
+        task<size_t> async_send_file_byte(Socket &socket, int file_fd, off_t offset) {
+            std::byte byte{};
+            ssize_t bytes = ::pread(file_fd, &byte, 1, offset);
+            if (bytes < 0) { throw std::system_error{errno, std::system_category(), "pread"}; }
+            if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::io_error), "truncated file"}; }
+            co_await async_send_all(socket, span<std::byte const>{&byte, 1});
+            co_return 1;
+        }
+
+        // reads from the file into a pooled buffer and sends it asynchronously
+        template<typename Socket>
+        task<size_t> async_send_file_part(Socket &socket, int file_fd, off_t offset, size_t count, size_t chunk_size) {
+            auto &pool = buffer_pool::local();
+            auto storage = pool.acquire(std::min(count, chunk_size));
+            scope_guard release = [&]() noexcept { pool.release(storage); };
+            ssize_t bytes = ::pread(file_fd, storage.data(), std::min(count, storage.size()), offset);
+            if (bytes < 0) { throw std::system_error{errno, std::system_category(), "pread"}; }
+            if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::io_error), "truncated file"}; }
+            co_await async_send_all(socket, as_bytes(storage.first(size_t(bytes))));
+            co_return size_t(bytes);
+        }
+    }// namespace detail
+
+    /** @brief Send @a count bytes of an asynchronous file (see unifex::open_file_read_only) starting at @a offset.
+     *
+     * The file is read with async_read_some_at into a pooled buffer of @a chunk_size bytes, for sockets that
+     * cannot use sendfile (TLS).
+     *
+     * @return Number of bytes sent.
+     */
+    template<typename Socket, typename File>
+        requires(not std::is_integral_v<File>)
+    task<size_t> async_send_file(Socket &socket, File &file, off_t offset, size_t count,
+                                 size_t chunk_size = 256 * 1024) {
+        auto &pool = buffer_pool::local();
+        auto storage = pool.acquire(std::min(count, chunk_size));
+        scope_guard release = [&]() noexcept { pool.release(storage); };
+        size_t sent = 0;
+        while (sent < count) {
+            auto buffer = storage.first(std::min(count - sent, storage.size()));
+            size_t bytes = co_await async_read_some_at(file, offset + off_t(sent), buffer);
+            if (bytes == 0) { throw std::system_error{std::make_error_code(std::errc::io_error), "truncated file"}; }
+            co_await detail::async_send_all(socket, as_bytes(buffer.first(bytes)));
+            sent += bytes;
+        }
+        co_return sent;
+    }
+
+    /** @brief Send @a count bytes of a file starting at @a offset.
+     *
+     * Plain TCP sockets use sendfile (no user-space copy) on the non-blocking socket, and wait for room in the
+     * socket send buffer asynchronously before going on with sendfile.
+     * Other sockets (TLS) use pooled reads of @a chunk_size bytes, prefer the asynchronous file overload for them.
+     *
+     * @return Number of bytes sent.
+     */
+    template<typename Socket>
+    task<size_t> async_send_file(Socket &socket, int file_fd, off_t offset, size_t count,
+                                 size_t chunk_size = 256 * 1024) {
+        size_t sent = 0;
+        if constexpr (detail::native_socket<Socket>) {
+            const int fd = socket.native_handle();
+            detail::set_non_blocking(fd);
+            while (true) {
+                sent += detail::sendfile_some(fd, file_fd, offset + off_t(sent), count - sent);
+                if (sent == count) { break; }
+                sent += co_await detail::async_send_file_byte(socket, file_fd, offset + off_t(sent));
+            }
+        } else {
+            while (sent < count) {
+                sent += co_await detail::async_send_file_part(socket, file_fd, offset + off_t(sent), count - sent,
+                                                              chunk_size);
+            }
+        }
+        co_return sent;
+    }
+
+}// namespace g6::web
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <g6/net/async_socket.hpp>
+#include <g6/net/ip_endpoint.hpp>
+
+#include <g6/web/web_cpo.hpp>
+
+#include <unifex/just.hpp>
+#include <unifex/scope_guard.hpp>
+#include <unifex/sync_wait.hpp>
+#include <unifex/task.hpp>
+#include <unifex/transform_done.hpp>
+#include <unifex/when_all.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace g6::web {
+
+    namespace detail {
+        // opens a listening socket allowing other listening sockets on the same port (SO_REUSEPORT),
+        // the kernel balances incoming connections between them
+        inline int open_reuse_port_listener(net::ip_endpoint const &endpoint, uint16_t port) {
+            sockaddr_storage storage{};
+            socklen_t length = 0;
+            auto address = endpoint.address().to_string();
+            if (auto *v4 = reinterpret_cast<sockaddr_in *>(&storage);
+                ::inet_pton(AF_INET, address.c_str(), &v4->sin_addr) == 1) {
+                v4->sin_family = AF_INET;
+                v4->sin_port = htons(port);
+                length = sizeof(sockaddr_in);
+            } else if (auto *v6 = reinterpret_cast<sockaddr_in6 *>(&storage);
+                       ::inet_pton(AF_INET6, address.c_str(), &v6->sin6_addr) == 1) {
+                v6->sin6_family = AF_INET6;
+                v6->sin6_port = htons(port);
+                length = sizeof(sockaddr_in6);
+            } else {
+                throw std::system_error{std::make_error_code(std::errc::invalid_argument), "open_reuse_port_listener"};
+            }
+            int fd = ::socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) { throw std::system_error{errno, std::system_category(), "socket"}; }
+            int enable = 1;
+            if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0
+                or ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0
+                or ::bind(fd, reinterpret_cast<sockaddr *>(&storage), length) != 0 or ::listen(fd, SOMAXCONN) != 0) {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error{error, std::system_category(), "open_reuse_port_listener"};
+            }
+            return fd;
+        }
+    }// namespace detail
+
+    /** @brief Multi-threaded server.
+     *
+     * Each shard owns its io context, its acceptor socket (bound with SO_REUSEPORT on the same endpoint),
+     * its server (so its async_scope) and runs on its own thread.
+     * Request handlers are built per shard, so routers and buffers are shard-local.
+     *
+     * @code
+     * web::sharded_server<io::context, web::proto::http_> server{web::proto::http, endpoint, 4};
+     * server.serve(stop_source, [&](size_t shard_index, io::context &context) {
+     *     return [&]<typename Session>(Session &session) { ... };
+     * });
+     * @endcode
+     */
+    template<typename Context, typename Proto>
+    class sharded_server
+    {
+        using server_type = decltype(web::make_server(std::declval<Context &>(), std::declval<Proto const &>(),
+                                                      std::declval<net::async_socket>()));
+
+        struct shard {
+            Context context{};
+            std::optional<server_type> server{};
+        };
+
+        std::vector<std::unique_ptr<shard>> shards_;
+        net::ip_endpoint endpoint_;
+
+    public:
+        sharded_server(Proto const &proto, net::ip_endpoint const &endpoint,
+                       size_t shard_count = std::max(1u, std::thread::hardware_concurrency()))
+            : endpoint_{endpoint} {
+            uint16_t port = endpoint.port();
+            for (size_t ii = 0; ii < shard_count; ++ii) {
+                auto &s = *shards_.emplace_back(std::make_unique<shard>());
+                int fd = detail::open_reuse_port_listener(endpoint, port);
+                s.server.emplace(web::make_server(s.context, proto, net::async_socket{s.context, fd}));
+                if (ii == 0) {
+                    // port might have been chosen by the system
+                    endpoint_ = *s.server->socket.local_endpoint();
+                    port = endpoint_.port();
+                }
+            }
+        }
+
+        sharded_server(sharded_server const &) = delete;
+        sharded_server(sharded_server &&) noexcept = default;
+
+        [[nodiscard]] auto const &local_endpoint() const noexcept { return endpoint_; }
+        [[nodiscard]] size_t size() const noexcept { return shards_.size(); }
+
+        /** @brief Apply @a fn on each shard server (eg.: to set options).
+         */
+        template<typename Fn>
+        void for_each(Fn &&fn) {
+            for (auto &s : shards_) { fn(*s->server); }
+        }
+
+        /** @brief Serve until @a stop_source is stopped.
+         *
+         * Blocks until all shards are terminated: each shard stops accepting, waits for its connections
+         * to terminate, then stops its context; all shard threads are joined.
+         *
+         * @param builder_factory Invoked on each shard thread with the shard index and context,
+         *                        returns the request handler builder of that shard (see web::async_serve).
+         */
+        template<typename BuilderFactory>
+        void serve(inplace_stop_source &stop_source, BuilderFactory &&builder_factory) {
+            std::vector<std::jthread> threads;
+            threads.reserve(shards_.size());
+            for (size_t ii = 0; ii < shards_.size(); ++ii) {
+                threads.emplace_back([this, ii, &stop_source, &builder_factory] {
+                    auto &s = *shards_[ii];
+                    inplace_stop_source context_stop_source{};
+                    try {
+                        auto builder = builder_factory(ii, s.context);
+                        sync_wait(when_all(
+                            [&]() -> task<void> {
+                                scope_guard stop_context = [&]() noexcept { context_stop_source.request_stop(); };
+                                // a stopped accept completes with done
+                                co_await transform_done(web::async_serve(*s.server, stop_source, builder),
+                                                        [] { return just(); });
+                                co_await s.server->cleanup();
+                            }(),
+                            [&]() -> task<void> {
+                                s.context.run(context_stop_source.get_token());
+                                co_return;
+                            }()));
+                    } catch (std::exception const &error) {
+                        spdlog::error("shard {} terminated: {}", ii, error.what());
+                        stop_source.request_stop();
+                    }
+                });
+            }
+        }
+    };
+
+}// namespace g6::web
@@ -3,84 +3,252 @@
  */
 #pragma once
 
-#include <ctre.hpp>
-
 #include <fmt/format.h>
 
 #include <g6/net/ip_endpoint.hpp>
 
+#include <algorithm>
 #include <charconv>
+#include <iterator>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace g6::web {
+
+/** @brief Non-owning URI view.
+ *
+ * Components are split on first access (no regex, no allocation), the viewed
+ * string must outlive the uri and the views it returns.
+ * Components are kept percent-encoded, see uri::unescape.
+ */
 class uri {
-  std::string uri_;
+public:
+  struct components {
+    std::string_view scheme{};
+    std::string_view host{};
+    std::string_view port{};
+    std::string_view path{};
+    std::string_view query{};
+    std::string_view fragment{};
+  };
 
-  struct impl_t
-  {
-    static constexpr ctll::fixed_string regex =
-        R"(^(([^:/?#]+):)?(//(([^/:?#]*))(:([0-9]+))?)?([^?#]*)(\?([^#]*))?(#(.*))?)";
-    using builder_type = ctre::regex_builder<regex>;
-    static constexpr inline auto match = ctre::regex_match_t<typename builder_type::type>();
-  } uri_impl;
+  /** @brief Query string parameter ("name=value"), percent-encoded.
+   */
+  struct query_parameter {
+    std::string_view name{};
+    std::string_view value{};
 
-public:
-  std::string_view scheme{};
-  std::string_view host{};
-  std::string_view port{};
-  std::string_view path{};
-  std::string_view parameters{};
-
-  uri(std::string_view input) noexcept :
-      uri_{std::move(input)} {
-    if (auto m = uri_impl.match(uri_); m) {
-      scheme = m.get<2>();
-      host = m.get<5>();
-      port = m.get<7>();
-      path = m.get<8>();
-      parameters = m.get<12>();
+    [[nodiscard]] std::string decoded_name() const { return unescape(name, true); }
+    [[nodiscard]] std::string decoded_value() const { return unescape(value, true); }
+  };
+
+  /** @brief Forward iterator over the '&' separated query parameters (empty ones are skipped).
+   */
+  class query_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = query_parameter;
+    using difference_type = std::ptrdiff_t;
+    using pointer = query_parameter const *;
+    using reference = query_parameter const &;
+
+    query_iterator() noexcept = default;
+    explicit query_iterator(std::string_view query) noexcept : remaining_{query} { next(); }
+
+    reference operator*() const noexcept { return current_; }
+    pointer operator->() const noexcept { return &current_; }
+
+    query_iterator &operator++() noexcept {
+      next();
+      return *this;
+    }
+    query_iterator operator++(int) noexcept {
+      auto copy = *this;
+      next();
+      return copy;
+    }
+
+    friend bool operator==(query_iterator const &lhs, query_iterator const &rhs) noexcept {
+      return lhs.end_ == rhs.end_ and lhs.remaining_.data() == rhs.remaining_.data();
     }
+
+  private:
+    void next() noexcept {
+      while (not remaining_.empty()) {
+        auto item = remaining_.substr(0, remaining_.find('&'));
+        remaining_.remove_prefix(std::min(item.size() + 1, remaining_.size()));
+        if (item.empty()) {
+          continue;
+        }
+        auto equal = item.find('=');
+        current_.name = item.substr(0, equal);
+        current_.value = equal == std::string_view::npos ? std::string_view{} : item.substr(equal + 1);
+        end_ = false;
+        return;
+      }
+      end_ = true;
+      remaining_ = {};
+    }
+
+    std::string_view remaining_{};
+    query_parameter current_{};
+    bool end_{true};
+  };
+
+  struct query_range {
+    std::string_view query;
+
+    [[nodiscard]] query_iterator begin() const noexcept { return query_iterator{query}; }
+    [[nodiscard]] query_iterator end() const noexcept { return {}; }
+  };
+
+  uri(std::string_view input) noexcept : input_{input} {}
+
+  [[nodiscard]] std::string_view str() const noexcept { return input_; }
+
+  [[nodiscard]] std::string_view scheme() const noexcept { return parts().scheme; }
+  [[nodiscard]] std::string_view host() const noexcept { return parts().host; }
+  [[nodiscard]] std::string_view port() const noexcept { return parts().port; }
+  [[nodiscard]] std::string_view path() const noexcept { return parts().path; }
+  [[nodiscard]] std::string_view query() const noexcept { return parts().query; }
+  [[nodiscard]] std::string_view fragment() const noexcept { return parts().fragment; }
+
+  [[nodiscard]] query_range query_parameters() const noexcept { return {query()}; }
+
+  /** @brief Value of the first @a name query parameter.
+   *
+   * - std::string_view: percent-encoded value,
+   * - std::string: decoded value,
+   * - bool: "1"/"true" or "0"/"false",
+   * - arithmetic types: parsed with std::from_chars.
+   *
+   * @return nullopt when the parameter is missing or cannot be converted to @a T.
+   */
+  template <typename T = std::string_view>
+  [[nodiscard]] std::optional<T> get(std::string_view name) const {
+    for (auto const &parameter : query_parameters()) {
+      if (parameter.name == name or
+          (parameter.name.find_first_of("%+") != std::string_view::npos and parameter.decoded_name() == name)) {
+        return convert<T>(parameter.value);
+      }
+    }
+    return {};
   }
 
   [[nodiscard]] std::optional<net::ip_endpoint> endpoint() const {
-    return net::ip_endpoint::from_string(fmt::format("{}:{}", host, port));
+    return net::ip_endpoint::from_string(fmt::format("{}:{}", host(), port()));
   }
 
   [[nodiscard]] bool uses_ssl() const noexcept {
     static std::vector ssl_schemes{"https", "wss"};
-    return std::find(std::begin(ssl_schemes), std::end(ssl_schemes), scheme) != std::end(ssl_schemes);
+    return std::find(std::begin(ssl_schemes), std::end(ssl_schemes), scheme()) != std::end(ssl_schemes);
   }
 
-  static auto escape(std::string_view input) {
-    std::string output{};
-    output.reserve(input.size());
-    for (size_t ii = 0; ii < input.size(); ++ii) {
-        static constexpr ctll::fixed_string printable_chars = R"([a-zA-Z0-9])";
-      if (not ctre::match<printable_chars>(std::string_view{&input[ii], 1})) {
-        output.reserve(output.capacity() + 3);
-        output.append(fmt::format(FMT_STRING("%{:02X}"), uint8_t(input[ii])));
-      } else {
-        output.append(std::string_view{&input[ii], 1});
+  /** @brief Split @a input into its components (RFC 3986 appendix B).
+   */
+  static constexpr components split(std::string_view input) noexcept {
+    components parts{};
+    auto take = [&input](size_t count) {
+      auto part = input.substr(0, count);
+      input.remove_prefix(std::min(count, input.size()));
+      return part;
+    };
+    if (auto end = input.find_first_of(":/?#"); end != 0 and end != std::string_view::npos and input[end] == ':') {
+      parts.scheme = take(end);
+      take(1);
+    }
+    if (input.starts_with("//")) {
+      take(2);
+      parts.host = take(input.find_first_of("/:?#"));
+      if (input.size() > 1 and input[0] == ':' and input[1] >= '0' and input[1] <= '9') {
+        take(1);
+        size_t digits = 0;
+        while (digits < input.size() and input[digits] >= '0' and input[digits] <= '9') { ++digits; }
+        parts.port = take(digits);
       }
     }
+    parts.path = take(input.find_first_of("?#"));
+    if (input.starts_with('?')) {
+      take(1);
+      parts.query = take(input.find('#'));
+    }
+    if (input.starts_with('#')) {
+      take(1);
+      parts.fragment = input;
+    }
+    return parts;
+  }
+
+  /** @brief Percent-encode @a input (all bytes but [a-zA-Z0-9]).
+   */
+  static std::string escape(std::string_view input) {
+    std::string output{};
+    escape(input, output);
     return output;
   }
-  static auto unescape(std::string_view input) {
+
+  /** @brief Percent-encode @a input, appending to @a output.
+   */
+  static void escape(std::string_view input, std::string &output);
+
+  /** @brief Percent-decode @a input.
+   *
+   * Malformed escapes ('%' not followed by two hex digits) are kept as is.
+   *
+   * @param plus_as_space decode '+' as a space (query strings, application/x-www-form-urlencoded).
+   */
+  static std::string unescape(std::string_view input, bool plus_as_space = false) {
     std::string output{};
-    output.reserve(input.size());
-    for (size_t ii = 0; ii < input.size(); ++ii) {
-        static constexpr ctll::fixed_string two_printable_chars = R"(%[a-zA-Z0-9]{2})";
-      if (ctre::match<two_printable_chars>(std::string_view{&input[ii], 3})) {
-        uint8_t c{};
-        std::from_chars(&input[ii + 1], &input[ii + 3], c, 16);
-        output.append(std::string_view{reinterpret_cast<char *>(&c), 1});
-        ii += 2;
+    unescape(input, output, plus_as_space);
+    return output;
+  }
+
+  /** @brief Percent-decode @a input, appending to @a output.
+   */
+  static void unescape(std::string_view input, std::string &output, bool plus_as_space = false);
+
+private:
+  template <typename T> static std::optional<T> convert(std::string_view value) {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+      return value;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      return unescape(value, true);
+    } else {
+      std::string decoded;
+      if (value.find_first_of("%+") != std::string_view::npos) {
+        decoded = unescape(value, true);
+        value = decoded;
+      }
+      if constexpr (std::is_same_v<T, bool>) {
+        if (value == "1" or value == "true") {
+          return true;
+        } else if (value == "0" or value == "false") {
+          return false;
+        }
+        return {};
       } else {
-        output.append(std::string_view{&input[ii], 1});
+        static_assert(std::is_arithmetic_v<T>, "unsupported query parameter type");
+        T result{};
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (error != std::errc{} or end != value.data() + value.size()) {
+          return {};
+        }
+        return result;
       }
     }
-    return output;
   }
+
+  components const &parts() const noexcept {
+    if (not parts_) {
+      parts_ = split(input_);
+    }
+    return *parts_;
+  }
+
+  std::string_view input_;
+  mutable std::optional<components> parts_{};
 };
 } // namespace g6
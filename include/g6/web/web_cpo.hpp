@@ -41,11 +41,22 @@ namespace g6::web {
                 return unifex::tag_invoke(*this, tag, connection, request);
             }
 
+            template<typename Tag, typename Connection, typename Request, typename Options>
+            auto operator()(Tag const& tag, Connection &connection, Request &request, Options const &options) const {
+                return unifex::tag_invoke(*this, tag, connection, request, options);
+            }
+
             // client connection upgrade
             template<typename BaseClient, typename FinalClient>
             auto operator()(BaseClient& base_client, std::type_identity<FinalClient> final_client_id) const {
                 return unifex::tag_invoke(*this, base_client, final_client_id);
             }
+
+            template<typename BaseClient, typename FinalClient, typename Options>
+            auto operator()(BaseClient& base_client, std::type_identity<FinalClient> final_client_id,
+                            Options const &options) const {
+                return unifex::tag_invoke(*this, base_client, final_client_id, options);
+            }
         } upgrade_connection;
     }
     using upgrade_connection_::upgrade_connection;
@@ -18,8 +18,11 @@ namespace g6 {
         class client : public connection<false, Socket>
         {
         public:
-            client(Context &context, Socket &&socket, net::ip_endpoint const& remote_endpoint) noexcept
-                : connection<false, Socket>{std::forward<Socket>(socket), remote_endpoint} {}
+            client(Context &context, Socket &&socket, net::ip_endpoint const& remote_endpoint,
+                   connection_options const &options = default_connection_options,
+                   std::optional<deflate_params> const &deflate = {}) noexcept
+                : connection<false, Socket>{std::forward<Socket>(socket), remote_endpoint,
+                                            connection<false, Socket>::max_ws_version_, options, deflate} {}
 
             static std::string random_string(size_t len) {
                 constexpr char charset[] = "0123456789"
@@ -51,7 +54,8 @@ namespace g6 {
         template<typename Context, typename Socket>
         task<ws::client<Context, Socket>> tag_invoke(tag_t<web::upgrade_connection>,
                                                      http::client<Context, Socket> &http_client,
-                                                     std::type_identity<ws::client<Context, Socket>>) {
+                                                     std::type_identity<ws::client<Context, Socket>>,
+                                                     ws::connection_options const &options = ws::default_connection_options) {
             std::string hash = crypto::base64::encode(ws::client<Context, Socket>::random_string(20));
             http::headers hdrs{
                 {"Connection", "Upgrade"},
@@ -59,6 +63,7 @@ namespace g6 {
                 {"Sec-WebSocket-Key", hash},
                 {"Sec-WebSocket-Version", std::to_string(ws::client<Context, Socket>::max_ws_version_)},
             };
+            if (options.deflate.enabled) { hdrs.emplace("Sec-WebSocket-Extensions", ws::deflate_offer(options.deflate)); }
             auto response = co_await net::async_send(http_client, "/", http::method::get, std::move(hdrs));
             while (net::has_pending_data(response)) {
                 co_await net::async_recv(response);
@@ -66,7 +71,9 @@ namespace g6 {
             if (response.status_code() != http::status::switching_protocols) {
                 throw std::system_error(int(response.status_code()), http::error_category, "upgrade_connection");
             }
-            co_return ws::client{web::get_context(http_client), std::move(web::get_socket(http_client)), http_client.remote_endpoint()};
+            auto deflate = ws::accept_deflate(options.deflate, response.header(http::header_id::sec_websocket_extensions));
+            co_return ws::client{web::get_context(http_client), std::move(web::get_socket(http_client)),
+                                 http_client.remote_endpoint(), options, deflate};
         }
     }// namespace http
 
@@ -79,5 +86,15 @@ namespace g6 {
             co_return co_await web::upgrade_connection(
                 http_client, std::type_identity<g6::ws::client<Context, net::async_socket>>{});
         }
+
+        template<typename Context>
+        task<ws::client<Context, net::async_socket>> tag_invoke(tag_t<net::async_connect>, Context &context,
+                                                                g6::web::proto::ws_ const &,
+                                                                const net::ip_endpoint &endpoint,
+                                                                ws::connection_options const &options) {
+            auto http_client = co_await net::async_connect(context, web::proto::http, endpoint);
+            co_return co_await web::upgrade_connection(
+                http_client, std::type_identity<g6::ws::client<Context, net::async_socket>>{}, options);
+        }
     }// namespace net
 }// namespace g6
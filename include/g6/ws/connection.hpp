@@ -1,13 +1,49 @@
 #pragma once
 
+#include <g6/web/buffer.hpp>
+#include <g6/web/gather.hpp>
+#include <g6/web/web_cpo.hpp>
+#include <g6/ws/deflate.hpp>
 #include <g6/ws/header.hpp>
+#include <g6/ws/mask.hpp>
 
+#include <unifex/async_manual_reset_event.hpp>
+#include <unifex/async_mutex.hpp>
+#include <unifex/just.hpp>
+#include <unifex/scheduler_concepts.hpp>
+#include <unifex/scope_guard.hpp>
 #include <unifex/span.hpp>
+#include <unifex/stop_when.hpp>
+#include <unifex/transform.hpp>
+#include <unifex/transform_done.hpp>
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <system_error>
 
 namespace g6::ws {
 
     template<bool is_server, typename Socket>
     class connection;
+
+    template<bool is_server, typename Socket>
+    task<size_t> async_send_in_place(connection<is_server, Socket> &conn, span<std::byte> data,
+                                     op_code opcode = op_code::text_frame);
+
+    template<bool is_server, typename Socket>
+    task<void> async_ping(connection<is_server, Socket> &conn, span<std::byte const> payload = {});
+
+    template<bool is_server, typename Socket>
+    task<void> async_close(connection<is_server, Socket> &conn, status_code code = status_code::normal_closure,
+                           std::string_view reason = {});
 }
 
 namespace g6::net {
@@ -18,7 +54,37 @@ namespace g6::net {
 
 namespace g6::ws {
 
+    struct connection_options {
+        // maximum size of a received message (all its frames), larger messages are rejected
+        size_t max_message_size = 16 * 1024 * 1024;
+        // size of the scratch buffer used to mask client frames (payload is masked and sent by parts)
+        size_t mask_chunk_size = 64 * 1024;
+        // size of the parts handed out when receiving compressed messages
+        size_t inflate_chunk_size = 16 * 1024;
+        // permessage-deflate extension
+        deflate_options deflate{};
+        // a ping is sent when nothing has been received for this long (0, the default, disables keepalive),
+        // see connection::async_keepalive: only enable it for handlers that keep receiving
+        std::chrono::milliseconds ping_interval = std::chrono::milliseconds{0};
+        // the connection is shut down when nothing (pong) has been received this long after a ping
+        std::chrono::milliseconds pong_timeout = std::chrono::seconds{10};
+    };
+
+    inline const connection_options default_connection_options{};
 
+    /** @brief WebSocket connection.
+     *
+     * Received frames are decoded as a stream: headers might be split between receives, several frames
+     * might be received at once, and payloads are handed out as they are received (a frame does not need
+     * to fit in the receive buffer).
+     * Messages are sent in a single frame, the header is sent with the caller's payload in a single
+     * write (see also ws::async_send_in_place for clients).
+     *
+     * Control frames are handled while receiving (even between the frames of a message): pings are
+     * answered, a close frame is answered (see close_status) and ends the connection (connection_reset), an
+     * invalid one (reserved status code, malformed UTF-8 reason) is answered with protocol_error (1002).
+     * Sends (messages and control frames) are serialized.
+     */
     template<bool is_server, typename Socket>
     class connection
     {
@@ -27,6 +93,67 @@ namespace g6::ws {
         const uint32_t ws_version;
         auto const &remote_endpoint() const noexcept { return remote_endpoint_; }
 
+        auto &options() noexcept { return options_; }
+
+        /** @brief Negotiated permessage-deflate parameters (nullopt when not in use).
+         */
+        [[nodiscard]] std::optional<deflate_params> const &deflate() const noexcept { return deflate_params_; }
+
+        /** @brief Status code of the close frame received from the peer (nullopt while not closed by the peer).
+         */
+        [[nodiscard]] std::optional<status_code> const &close_status() const noexcept { return close_status_; }
+
+        /** @brief Send pings while the connection is idle, shut it down when the peer does not answer.
+         *
+         * Runs until stop_keepalive is called or the connection is shut down (see connection_options::ping_interval,
+         * disabled by default). Servers run it beside the request handler.
+         *
+         * Pongs are only seen by the receive operations: a receive must be pending meanwhile (a handler that
+         * only sends, or that is busy for longer than ping_interval + pong_timeout, gets its connection shut
+         * down even though the peer answers).
+         */
+        template<typename Scheduler>
+        task<void> async_keepalive(Scheduler sched) {
+            if (options_.ping_interval.count() == 0) { co_return; }
+            auto &control = *control_;
+            // false when stopped (stop_keepalive, stop request or close received)
+            auto async_wait = [&](std::chrono::milliseconds delay) -> task<bool> {
+                bool elapsed = false;
+                co_await transform_done(
+                    stop_when(schedule_at(sched, now(sched) + delay) | transform([&elapsed] { elapsed = true; }),
+                              control.keepalive_stop.async_wait()),
+                    [] { return just(); });
+                co_return elapsed and not control.keepalive_stopped and not close_received_;
+            };
+            size_t seen = activity_;
+            while (co_await async_wait(options_.ping_interval)) {
+                if (activity_ != seen) {
+                    // peer is alive
+                    seen = activity_;
+                    continue;
+                }
+                try {
+                    co_await async_send_control(op_code::ping, {});
+                } catch (std::system_error const &) {
+                    // the receiving side reports the failure
+                    break;
+                }
+                if (not co_await async_wait(options_.pong_timeout)) { break; }
+                if (activity_ == seen) {
+#ifdef G6_WEB_DEBUG
+                    spdlog::debug("ws::connection<{}>: no pong received, shutting down", is_server ? "server" : "client");
+#endif
+                    shutdown();
+                    break;
+                }
+                seen = activity_;
+            }
+        }
+
+        void stop_keepalive() noexcept {
+            control_->keepalive_stopped = true;
+            control_->keepalive_stop.set();
+        }
 
         connection(connection const &) = delete;
         connection(connection &&) noexcept = default;
@@ -39,111 +166,465 @@ namespace g6::ws {
 
     private:
         Socket socket_;
-        std::array<std::byte, 1024> data_{};
+        web::receive_buffer data_{};
+        // received bytes not decoded yet
+        size_t begin_{0};
+        size_t end_{0};
         net::ip_endpoint remote_endpoint_;
+        connection_options options_{};
+
+        // current frame
+        header frame_{};
+        uint64_t frame_remaining_{0};
+        size_t key_offset_{0};
+        // current message: payload size on the wire, and decompressed size of compressed messages
+        size_t message_size_{0};
+        size_t inflated_size_{0};
+        bool in_message_{false};
+        // permessage-deflate
+        std::optional<deflate_params> deflate_params_{};
+        std::optional<deflate_codec> deflate_{};
+        // current compressed message: received payload not decompressed yet
+        bool inflating_{false};
+        bool inflate_tail_{false};
+        span<std::byte const> inflate_input_{};
+        // control frames
+        struct control_state {
+            async_mutex send_mutex{};
+            async_manual_reset_event keepalive_stop{};
+            bool keepalive_stopped{false};
+        };
+        // heap allocated to keep the connection movable
+        std::unique_ptr<control_state> control_ = std::make_unique<control_state>();
+        // receives, to detect idle connections
+        size_t activity_{0};
+        bool close_sent_{false};
+        bool close_received_{false};
+        std::optional<status_code> close_status_{};
 
+        /** @brief Current message.
+         *
+         * Payload parts are valid until the next receive on the connection.
+         */
         class request
         {
             connection &connection_;
-            unifex::span<std::byte> buffer_;
-            header header_;
-            size_t current_payload_offset_ = 0;
 
-            explicit request(connection &conn, size_t received_size) noexcept
-                : connection_{conn}, buffer_{connection_.data_}, header_{header::parse(
-                                                                     span{buffer_.data(), received_size})} {
+            explicit request(connection &conn) noexcept : connection_{conn} {}
+
+            auto async_recv_payload() { return connection_.async_recv_payload(); }
+            [[nodiscard]] bool pending() const noexcept { return connection_.in_message_ or connection_.inflating_; }
+
+            friend task<request> net::tag_invoke<is_server, Socket>(tag_t<net::async_recv>, connection &conn);
+
+            friend task<span<const std::byte>> tag_invoke(tag_t<net::async_recv>, request &req) {
+                auto payload = co_await req.async_recv_payload();
+                co_return as_bytes(payload);
+            }
+
+            friend bool tag_invoke(tag_t<net::has_pending_data>, request &req) { return req.pending(); }
+
+        public:
+            [[nodiscard]] op_code opcode() const noexcept { return connection_.message_opcode_; }
+            [[nodiscard]] bool compressed() const noexcept { return connection_.message_compressed_; }
+        };
+
+        op_code message_opcode_{op_code::text_frame};
+        bool message_compressed_{false};
+
+        friend task<request> net::tag_invoke<is_server, Socket>(tag_t<net::async_recv>, connection &conn);
+
+        // receive more bytes, unread ones are kept (moved to the buffer start)
+        task<void> async_fill() {
+            if (begin_ != 0) {
+                auto data = data_.data();
+                std::memmove(data.data(), data.data() + begin_, end_ - begin_);
+                end_ -= begin_;
+                begin_ = 0;
+            }
+            auto buffer = data_.prepare(end_);
+            size_t bytes = co_await net::async_recv(socket_, buffer);
+            if (bytes == 0) { throw std::system_error(std::make_error_code(std::errc::connection_reset)); }
+            data_.commit(bytes);
+            end_ += bytes;
+            ++activity_;
+        }
+
+        // shut the socket down so that pending operations fail
+        void shutdown() noexcept {
+            if constexpr (requires { socket_.native_handle(); }) { ::shutdown(socket_.native_handle(), SHUT_RDWR); }
+        }
+
+        // next data frame header, control frames are handled on the way
+        task<header> async_recv_data_header() {
+            while (true) {
+                auto h = co_await async_recv_header();
+                if ((uint8_t(h.opcode) & 0x08) == 0) { co_return h; }
+                co_await async_handle_control(h);
+            }
+        }
+
+        task<void> async_handle_control(header const &h) {
+            if (not h.fin or h.payload_length > max_control_payload or h.rsv1 or h.rsv2 or h.rsv3) {
+                throw std::system_error(std::make_error_code(std::errc::protocol_error));
+            }
+            while (end_ - begin_ < h.payload_length) { co_await async_fill(); }
+            std::array<std::byte, max_control_payload> storage{};
+            auto payload = span{storage.data(), size_t(h.payload_length)};
+            auto input = data_.data().subspan(begin_, payload.size());
+            begin_ += payload.size();
+            if (h.mask) {
+                apply_mask(input, payload, h.masking_key);
+            } else if (not payload.empty()) {
+                std::memcpy(payload.data(), input.data(), payload.size());
+            }
 #ifdef G6_WEB_DEBUG
-                spdlog::debug("ws::request<{}>:\n"
-                              " - received {} bytes\n"
-                              " - payload_length={} bytes\n"
-                              " - payload_offset={} bytes",
-                              is_server ? "server" : "client", received_size, header_.payload_length,
-                              header_.payload_offset);
-                spdlog::debug("ws::request<{}>: first byte={}, buffer=0x{}", is_server ? "server" : "client",
-                              (uint8_t) buffer_[0], (void *) buffer_.data());
+            spdlog::debug("ws::connection<{}>: control frame opcode={} payload_length={}",
+                          is_server ? "server" : "client", int(h.opcode), h.payload_length);
 #endif
-                copy_body(span{buffer_.data(), received_size});
+            switch (h.opcode) {
+                case op_code::ping:
+                    if (not close_sent_) { co_await async_send_control(op_code::pong, as_bytes(payload)); }
+                    break;
+                case op_code::pong:
+                    break;
+                case op_code::connection_close: {
+                    close_received_ = true;
+                    uint16_t code = uint16_t(status_code::no_status_code);
+                    if (payload.size() >= 2) { code = uint16_t((uint16_t(payload[0]) << 8) | uint16_t(payload[1])); }
+                    const auto reason = std::string_view{reinterpret_cast<char const *>(payload.data()), payload.size()};
+                    if (payload.size() == 1
+                        or (payload.size() >= 2 and (not is_valid_close_code(code) or not is_valid_utf8(reason.substr(2))))) {
+                        // invalid close frame: the connection is failed
+                        if (not close_sent_) {
+                            constexpr std::array error{std::byte(uint16_t(status_code::protocol_error) >> 8),
+                                                       std::byte(uint16_t(status_code::protocol_error) & 0xff)};
+                            co_await async_send_control(op_code::connection_close, span{error.data(), error.size()});
+                        }
+                        throw std::system_error(std::make_error_code(std::errc::protocol_error));
+                    }
+                    close_status_ = status_code(code);
+                    if (not close_sent_) {
+                        // echo the status code
+                        co_await async_send_control(op_code::connection_close,
+                                                    as_bytes(payload.first(payload.size() >= 2 ? 2 : 0)));
+                    }
+                    throw std::system_error(std::make_error_code(std::errc::connection_reset));
+                }
+                default:
+                    throw std::system_error(std::make_error_code(std::errc::protocol_error));
             }
+        }
 
-            void copy_body(span<std::byte const> buffer) noexcept {
-                if (header_.mask) {
-                    std::byte masking_key[4]{};
-                    std::memcpy(masking_key, &header_.masking_key, 4);
-                    for (size_t ii = 0; ii < header_.payload_length; ++ii) {
-                        buffer_[current_payload_offset_++] =
-                            buffer[header_.payload_offset + ii] xor masking_key[ii % 4];
-                    }
-                } else {
-                    std::memcpy(buffer_.data(), &buffer[header_.payload_offset], header_.payload_length);
-                    current_payload_offset_ += header_.payload_length;
+        task<void> async_send_control(op_code opcode, span<std::byte const> payload) {
+            header h{
+                .fin = true,
+                .opcode = opcode,
+                .mask = not is_server,
+                .payload_length = payload.size(),
+                .masking_key = is_server ? 0 : make_masking_key(),
+            };
+            std::array<std::byte, header::max_header_size + max_control_payload> frame{};
+            h.serialize(frame);
+            if (h.mask) {
+                apply_mask(payload, span{frame.data() + h.payload_offset, payload.size()}, h.masking_key);
+            } else if (not payload.empty()) {
+                std::memcpy(frame.data() + h.payload_offset, payload.data(), payload.size());
+            }
+            auto &mutex = control_->send_mutex;
+            co_await mutex.async_lock();
+            scope_guard unlock = [&]() noexcept { mutex.unlock(); };
+            if (close_sent_) { co_return; }
+            close_sent_ = opcode == op_code::connection_close;
+            co_await web::detail::async_send_all(socket_, as_bytes(span{frame.data(), h.payload_offset + payload.size()}));
+        }
+
+        task<header> async_recv_header() {
+            while (true) {
+                auto data = data_.data();
+                if (auto h = header::try_parse(span{data.data() + begin_, end_ - begin_})) {
+                    begin_ += h->payload_offset;
+                    co_return *h;
                 }
+                co_await async_fill();
+            }
+        }
+
+        void begin_frame(header const &h) {
+            // rsv1 (compressed) is only set on the first frame of a message
+            if (h.rsv2 or h.rsv3 or (h.rsv1 and (h.opcode == op_code::continuation_frame or not deflate_))) {
+                throw std::system_error(std::make_error_code(std::errc::protocol_error));
             }
+            message_size_ += h.payload_length;
+            if (message_size_ > options_.max_message_size) {
+                throw std::system_error(std::make_error_code(std::errc::message_size));
+            }
+            frame_ = h;
+            frame_remaining_ = h.payload_length;
+            key_offset_ = 0;
+            in_message_ = not(h.fin and h.payload_length == 0);
+#ifdef G6_WEB_DEBUG
+            spdlog::debug("ws::connection<{}>: frame opcode={} fin={} payload_length={}",
+                          is_server ? "server" : "client", int(h.opcode), h.fin, h.payload_length);
+#endif
+        }
 
-            friend task<request> net::tag_invoke<is_server, Socket>(tag_t<net::async_recv>, connection &conn);
+        task<void> async_begin_message() {
+            // unread part of the previous message is skipped
+            while (in_message_ or inflating_) { co_await async_recv_payload(); }
+            auto h = co_await async_recv_data_header();
+            if (h.opcode != op_code::text_frame and h.opcode != op_code::binary_frame) {
+                throw std::system_error(std::make_error_code(std::errc::protocol_error));
+            }
+            message_opcode_ = h.opcode;
+            message_compressed_ = h.rsv1;
+            message_size_ = 0;
+            begin_frame(h);
+            if (message_compressed_) {
+                // compressed size is checked by begin_frame, decompressed size by async_recv_inflated
+                inflated_size_ = 0;
+                inflating_ = true;
+                inflate_tail_ = false;
+                inflate_input_ = {};
+            }
+        }
 
-            friend task<span<const std::byte>> tag_invoke(tag_t<net::async_recv>, request &req) {
-                uint32_t payload_offset = std::exchange(req.current_payload_offset_, 0);
-                co_return as_bytes(span{req.buffer_.data(), payload_offset});
-                //                    auto &socket = request.session_.socket();
-                //                    std::array<std::byte, 1024> buffer{};
-                //                    auto bytes_received = co_await net::async_recv(socket, buffer);
-                //                    request.header_ = header::parse(span{buffer.data(), bytes_received});
-                //                    request.copy_body(as_bytes(span{buffer}));
-                //                    co_return as_bytes(span{request.buffer_.data(), bytes_received});
+        // next part of the current message payload (empty when the message is complete)
+        task<span<std::byte>> async_recv_payload() {
+            if (message_compressed_) {
+                co_return co_await async_recv_inflated();
+            } else {
+                co_return co_await async_recv_frame_payload();
+            }
+        }
+
+        // next decompressed part of the current message
+        task<span<std::byte>> async_recv_inflated() {
+            while (inflating_) {
+                if (inflate_input_.empty() and not deflate_->decompress_full()) {
+                    if (in_message_) {
+                        inflate_input_ = co_await async_recv_frame_payload();
+                    } else if (not inflate_tail_) {
+                        inflate_tail_ = true;
+                        inflate_input_ = span<std::byte const>{deflate_codec::tail, sizeof(deflate_codec::tail)};
+                    } else {
+                        inflating_ = false;
+                        deflate_->end_decompress();
+                        break;
+                    }
+                }
+                auto output = deflate_->decompress(inflate_input_, options_.inflate_chunk_size);
+                inflated_size_ += output.size();
+                if (inflated_size_ > options_.max_message_size) {
+                    throw std::system_error(std::make_error_code(std::errc::message_size));
+                }
+                if (not output.empty()) { co_return output; }
             }
+            co_return span<std::byte>{};
+        }
 
-            friend bool tag_invoke(tag_t<net::has_pending_data>, request &req) {
-                return !req.header_.fin || req.current_payload_offset_ != 0;
+        // next part of the current message frames payload
+        task<span<std::byte>> async_recv_frame_payload() {
+            if (not in_message_) { co_return span<std::byte>{}; }
+            while (frame_remaining_ == 0) {
+                auto h = co_await async_recv_data_header();
+                if (h.opcode != op_code::continuation_frame) {
+                    throw std::system_error(std::make_error_code(std::errc::protocol_error));
+                }
+                begin_frame(h);
             }
-        };
+            if (begin_ == end_) { co_await async_fill(); }
+            const auto size = size_t(std::min<uint64_t>(frame_remaining_, end_ - begin_));
+            auto payload = data_.data().subspan(begin_, size);
+            begin_ += size;
+            frame_remaining_ -= size;
+            if (frame_.mask) { key_offset_ = apply_mask(payload, frame_.masking_key, key_offset_); }
+            if (frame_remaining_ == 0 and frame_.fin) { in_message_ = false; }
+            co_return payload;
+        }
 
-        friend task<request> net::tag_invoke<is_server, Socket>(tag_t<net::async_recv>, connection &conn);
+        // sends are serialized, no data frame can be sent once the close frame has been
+        task<void> async_lock_send() {
+            co_await control_->send_mutex.async_lock();
+            if (close_sent_) {
+                control_->send_mutex.unlock();
+                throw std::system_error(std::make_error_code(std::errc::not_connected));
+            }
+        }
+
+        void unlock_send() noexcept { control_->send_mutex.unlock(); }
 
-        friend task<size_t> tag_invoke(tag_t<net::async_send>, connection &conn, span<std::byte const> data) {
-            size_t data_offset = 0;
-            while (data_offset < data.size()) {
-                header h{
-                    .opcode = op_code::text_frame,
-                };
-                size_t payload_size = std::min(conn.data_.size(), data.size() - data_offset);
-                auto [send_size, payload_len] = h.calc_payload_size(payload_size, conn.data_.size());
-                h.fin = (data_offset + payload_len >= data.size());
-                h.serialize(span{conn.data_});
-                std::memcpy(&conn.data_[h.payload_offset], data.data() + data_offset, h.payload_length);
-                data_offset += h.payload_length;
+        header make_header(size_t payload_length, op_code opcode, bool compressed = false) const noexcept {
+            return {
+                .fin = true,
+                .rsv1 = compressed,
+                .opcode = opcode,
+                // client frames must be masked
+                .mask = not is_server,
+                .payload_length = payload_length,
+                .masking_key = is_server ? 0 : make_masking_key(),
+            };
+        }
+
+        friend task<size_t> tag_invoke(tag_t<net::async_send>, connection &conn, span<std::byte const> data,
+                                       op_code opcode = op_code::text_frame) {
+            if (opcode != op_code::text_frame and opcode != op_code::binary_frame) {
+                throw std::system_error(std::make_error_code(std::errc::invalid_argument));
+            }
+            co_await conn.async_lock_send();
+            scope_guard unlock = [&]() noexcept { conn.unlock_send(); };
+            const bool compressed = conn.deflate_ and data.size() >= conn.options_.deflate.min_size;
+            scope_guard end_compress = [&]() noexcept {
+                if (compressed) { conn.deflate_->end_compress(); }
+            };
+            if (compressed) { data = conn.deflate_->compress(data); }
+            auto h = conn.make_header(data.size(), opcode, compressed);
+            std::array<std::byte, header::max_header_size> header_data{};
+            h.serialize(header_data);
+            auto head = as_bytes(span{header_data}.first(h.payload_offset));
 #ifdef G6_WEB_DEBUG
-                spdlog::debug("ws::connection<{}>: send_size={} bytes", is_server ? "server" : "client", send_size);
-                spdlog::debug("ws::connection<{}>: payload_length={} bytes", is_server ? "server" : "client",
-                              h.payload_length);
-                spdlog::debug("ws::connection<{}>: payload_offset={} bytes", is_server ? "server" : "client",
-                              h.payload_offset);
-                spdlog::debug("ws::connection<{}>: first byte={}", is_server ? "server" : "client",
-                              (uint8_t) conn.data_[0]);
+            spdlog::debug("ws::connection<{}>: payload_length={} bytes, payload_offset={} bytes",
+                          is_server ? "server" : "client", h.payload_length, h.payload_offset);
 #endif
-                co_await net::async_send(conn.socket_, as_bytes(span{conn.data_.data(), send_size}));
+            if constexpr (is_server) {
+                // frame header and payload in a single write, payload is not copied
+                co_await web::async_gather_send(conn.socket_, head, data);
+            } else {
+                // caller's payload is const: masked by parts into a scratch buffer
+                auto &pool = web::buffer_pool::local();
+                auto scratch = pool.acquire(std::min(data.size(), conn.options_.mask_chunk_size));
+                scope_guard release = [&]() noexcept { pool.release(scratch); };
+                size_t key_offset = 0;
+                do {
+                    auto part = data.first(std::min(data.size(), scratch.size()));
+                    key_offset = apply_mask(part, scratch, h.masking_key, key_offset);
+                    co_await web::async_gather_send(conn.socket_, head, as_bytes(scratch.first(part.size())));
+                    head = {};
+                    data = data.subspan(part.size());
+                } while (not data.empty());
             }
-            //            conn.socket_.close_send();
-            co_return data_offset;
+            co_return h.payload_length;
+        }
+
+        template<bool is_server_, typename Socket_>
+        friend task<size_t> async_send_in_place(connection<is_server_, Socket_> &conn, span<std::byte> data,
+                                                op_code opcode);
+
+        template<typename Socket_>
+        friend task<size_t> async_send_frame(connection<true, Socket_> &conn, span<std::byte const> frame);
+
+        template<bool is_server_, typename Socket_>
+        friend task<void> async_ping(connection<is_server_, Socket_> &conn, span<std::byte const> payload);
+
+        template<bool is_server_, typename Socket_>
+        friend task<void> async_close(connection<is_server_, Socket_> &conn, status_code code, std::string_view reason);
+
+        static constexpr size_t max_control_payload = 125;
+
+        friend Socket &tag_invoke(tag_t<web::get_socket>, connection &conn) noexcept { return conn.socket_; }
+
+        static uint32_t make_masking_key() noexcept {
+            thread_local std::mt19937 generator{std::random_device{}()};
+            return uint32_t(generator());
         }
 
     protected:
         explicit connection(Socket &&socket, net::ip_endpoint const &remote_endpoint,
-                            uint32_t version = max_ws_version_) noexcept
-            : socket_{std::forward<Socket>(socket)}, remote_endpoint_{remote_endpoint}, ws_version{version} {}
+                            uint32_t version = max_ws_version_,
+                            connection_options const &options = default_connection_options,
+                            std::optional<deflate_params> const &deflate = {}) noexcept
+            : socket_{std::forward<Socket>(socket)}, remote_endpoint_{remote_endpoint}, options_{options},
+              deflate_params_{deflate}, ws_version{version} {
+            if (deflate_params_) { deflate_.emplace(*deflate_params_, is_server, options_.deflate.level); }
+        }
     };
 
+
+    /** @brief Send @a data as a single frame, masking it in place.
+     *
+     * Same as net::async_send, but client frames are masked directly in @a data instead of
+     * a scratch buffer: the payload is sent with its header in a single write (compressed messages are
+     * sent by net::async_send).
+     * @a data content is unspecified once sent by a client connection.
+     */
+    template<bool is_server, typename Socket>
+    task<size_t> async_send_in_place(connection<is_server, Socket> &conn, span<std::byte> data, op_code opcode) {
+        if (is_server or (conn.deflate_ and data.size() >= conn.options_.deflate.min_size)) {
+            // nothing to mask, or masked once compressed
+            co_return co_await net::async_send(conn, as_bytes(data), opcode);
+        } else {
+            if (opcode != op_code::text_frame and opcode != op_code::binary_frame) {
+                throw std::system_error(std::make_error_code(std::errc::invalid_argument));
+            }
+            co_await conn.async_lock_send();
+            scope_guard unlock = [&]() noexcept { conn.unlock_send(); };
+            auto h = conn.make_header(data.size(), opcode);
+            std::array<std::byte, header::max_header_size> header_data{};
+            h.serialize(header_data);
+            apply_mask(data, h.masking_key);
+            co_await web::async_gather_send(conn.socket_, as_bytes(span{header_data}.first(h.payload_offset)),
+                                            as_bytes(data));
+            co_return h.payload_length;
+        }
+    }
+
+    /** @brief Send an already encoded frame (header and payload, eg.: a ws::shared_frame).
+     *
+     * Server connections only: client frames must be masked with their own key.
+     */
+    template<typename Socket>
+    task<size_t> async_send_frame(connection<true, Socket> &conn, span<std::byte const> frame) {
+        co_await conn.async_lock_send();
+        scope_guard unlock = [&]() noexcept { conn.unlock_send(); };
+        co_await web::detail::async_send_all(conn.socket_, frame);
+        co_return frame.size();
+    }
+
+    /** @brief Send a ping (@a payload up to 125 bytes).
+     *
+     * The pong is received (and ignored) by the receive operations, see connection::async_keepalive.
+     */
+    template<bool is_server, typename Socket>
+    task<void> async_ping(connection<is_server, Socket> &conn, span<std::byte const> payload) {
+        if (payload.size() > connection<is_server, Socket>::max_control_payload) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument));
+        }
+        co_await conn.async_send_control(op_code::ping, payload);
+    }
+
+    /** @brief Close handshake: send a close frame and wait for the peer's one.
+     *
+     * Messages received meanwhile are discarded. A peer that does not answer is detected by
+     * connection::async_keepalive. Once closed, sending messages fails (not_connected).
+     *
+     * @param reason UTF-8 text, up to 123 bytes.
+     */
+    template<bool is_server, typename Socket>
+    task<void> async_close(connection<is_server, Socket> &conn, status_code code, std::string_view reason) {
+        std::array<std::byte, connection<is_server, Socket>::max_control_payload> payload{};
+        if (reason.size() > payload.size() - 2) { throw std::system_error(std::make_error_code(std::errc::invalid_argument)); }
+        payload[0] = std::byte(uint16_t(code) >> 8);
+        payload[1] = std::byte(uint16_t(code) & 0xff);
+        if (not reason.empty()) { std::memcpy(payload.data() + 2, reason.data(), reason.size()); }
+        co_await conn.async_send_control(op_code::connection_close, as_bytes(span{payload.data(), 2 + reason.size()}));
+        try {
+            while (not conn.close_received_) { co_await net::async_recv(conn); }
+        } catch (std::system_error const &) {
+            // peer's close frame (connection_reset) or dead connection
+        }
+        if constexpr (is_server) {
+            // servers close the TCP connection first
+            conn.shutdown();
+        }
+    }
+
 }// namespace g6::ws
 
 namespace g6::net {
     template<bool is_server, typename Socket>
     task<typename ws::connection<is_server, Socket>::request> tag_invoke(tag_t<net::async_recv>,
                                                                          ws::connection<is_server, Socket> &conn) {
-        auto &socket = conn.socket_;
-#ifdef G6_WEB_DEBUG
-        spdlog::debug("ws::connection<{}>: buffer=0x{}", is_server ? "server" : "client", (void *) conn.data_.data());
-#endif
-        auto bytes_received = co_await net::async_recv(socket, span{conn.data_});
-        if (bytes_received == 0) { throw std::system_error(std::make_error_code(std::errc::connection_reset)); }
-        co_return typename ws::connection<is_server, Socket>::request{conn, bytes_received};
+        co_await conn.async_begin_message();
+        co_return typename ws::connection<is_server, Socket>::request{conn};
     }
 }// namespace g6::net
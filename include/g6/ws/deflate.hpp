@@ -0,0 +1,309 @@
+#pragma once
+
+#include <g6/http/header_map.hpp>
+#include <g6/web/deflate.hpp>
+
+#include <unifex/span.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace g6::ws {
+
+    /** @brief permessage-deflate extension settings (RFC 7692).
+     */
+    struct deflate_options {
+        // offer (client) or accept (server) the extension
+        bool enabled = false;
+        int level = Z_DEFAULT_COMPRESSION;
+        // LZ77 window (9..15) of the server/client compressor, lower values use less memory
+        int server_max_window_bits = 15;
+        int client_max_window_bits = 15;
+        // compressors restart for each message: worse ratio, but no zlib state is kept between messages
+        bool server_no_context_takeover = false;
+        bool client_no_context_takeover = false;
+        // messages smaller than this are sent uncompressed
+        size_t min_size = 64;
+        // zlib state size limit per connection (0 means unlimited),
+        // windows are narrowed to fit, the extension is declined when they cannot
+        size_t max_memory = 0;
+    };
+
+    /** @brief Negotiated permessage-deflate parameters.
+     */
+    struct deflate_params {
+        bool server_no_context_takeover = false;
+        bool client_no_context_takeover = false;
+        int server_max_window_bits = 15;
+        int client_max_window_bits = 15;
+
+        /** @brief Sec-WebSocket-Extensions value (server response).
+         */
+        [[nodiscard]] std::string to_string() const {
+            std::string value{"permessage-deflate"};
+            if (server_no_context_takeover) { value += "; server_no_context_takeover"; }
+            if (client_no_context_takeover) { value += "; client_no_context_takeover"; }
+            if (server_max_window_bits != 15) {
+                value += "; server_max_window_bits=" + std::to_string(server_max_window_bits);
+            }
+            if (client_max_window_bits != 15) {
+                value += "; client_max_window_bits=" + std::to_string(client_max_window_bits);
+            }
+            return value;
+        }
+    };
+
+    namespace detail {
+        inline std::string_view trim(std::string_view value) noexcept {
+            auto first = value.find_first_not_of(" \t");
+            if (first == std::string_view::npos) { return {}; }
+            return value.substr(first, value.find_last_not_of(" \t") - first + 1);
+        }
+
+        // next @a separator separated item of @a value
+        inline std::string_view next_item(std::string_view &value, char separator) noexcept {
+            auto end = value.find(separator);
+            auto item = trim(value.substr(0, end));
+            value = end == std::string_view::npos ? std::string_view{} : value.substr(end + 1);
+            return item;
+        }
+
+        // zlib memory used by a raw deflate/inflate pair (see zconf.h)
+        constexpr size_t deflate_memory(int deflate_window_bits, int inflate_window_bits) noexcept {
+            constexpr int mem_level = 8;
+            return (size_t{1} << (deflate_window_bits + 2)) + (size_t{1} << (mem_level + 9))
+                 + (size_t{1} << inflate_window_bits) + 7 * 1024;
+        }
+
+        // zlib raw deflate does not support 8 bits windows
+        constexpr int compress_window_bits(int bits) noexcept { return std::clamp(bits, 9, 15); }
+
+        /** @brief Parsed permessage-deflate offer (or response).
+         */
+        struct extension_offer {
+            bool server_no_context_takeover = false;
+            bool client_no_context_takeover = false;
+            std::optional<int> server_max_window_bits{};
+            // client_max_window_bits might be offered without value
+            bool client_max_window_bits_present = false;
+            std::optional<int> client_max_window_bits{};
+
+            // nullopt when @a extension is not a (valid) permessage-deflate one
+            static std::optional<extension_offer> parse(std::string_view extension) noexcept {
+                if (not http::detail::iequals(next_item(extension, ';'), "permessage-deflate")) { return {}; }
+                extension_offer offer{};
+                auto window_bits = [](std::string_view value) -> std::optional<int> {
+                    if (value.size() >= 2 and value.front() == '"' and value.back() == '"') {
+                        value = value.substr(1, value.size() - 2);
+                    }
+                    int bits = 0;
+                    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), bits);
+                    if (error != std::errc{} or end != value.data() + value.size() or bits < 8 or bits > 15) {
+                        return {};
+                    }
+                    return bits;
+                };
+                while (not extension.empty()) {
+                    auto param = next_item(extension, ';');
+                    auto equal = param.find('=');
+                    auto name = trim(param.substr(0, equal));
+                    auto value = equal == std::string_view::npos ? std::string_view{} : trim(param.substr(equal + 1));
+                    if (name == "server_no_context_takeover" and value.empty()
+                        and not std::exchange(offer.server_no_context_takeover, true)) {
+                        continue;
+                    } else if (name == "client_no_context_takeover" and value.empty()
+                               and not std::exchange(offer.client_no_context_takeover, true)) {
+                        continue;
+                    } else if (name == "server_max_window_bits" and not offer.server_max_window_bits) {
+                        if ((offer.server_max_window_bits = window_bits(value))) { continue; }
+                    } else if (name == "client_max_window_bits" and not offer.client_max_window_bits_present) {
+                        offer.client_max_window_bits_present = true;
+                        if (value.empty() or (offer.client_max_window_bits = window_bits(value))) { continue; }
+                    }
+                    // unknown, duplicated or invalid parameter
+                    return {};
+                }
+                return offer;
+            }
+        };
+
+        // narrow windows so that zlib state fits in max_memory
+        inline bool fit_memory(size_t max_memory, int &deflate_window_bits, int &inflate_window_bits,
+                               bool inflate_window_negotiable) noexcept {
+            if (max_memory == 0) { return true; }
+            while (deflate_memory(deflate_window_bits, inflate_window_bits) > max_memory) {
+                if (deflate_window_bits > 9 and deflate_window_bits >= inflate_window_bits) {
+                    --deflate_window_bits;
+                } else if (inflate_window_negotiable and inflate_window_bits > 9) {
+                    --inflate_window_bits;
+                } else if (deflate_window_bits > 9) {
+                    --deflate_window_bits;
+                } else {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }// namespace detail
+
+    /** @brief Server side negotiation: pick the first acceptable offer of the client Sec-WebSocket-Extensions.
+     *
+     * @return nullopt when the extension is declined.
+     */
+    inline std::optional<deflate_params> negotiate_deflate(deflate_options const &options,
+                                                           std::string_view extensions) {
+        if (not options.enabled) { return {}; }
+        while (not extensions.empty()) {
+            auto offer = detail::extension_offer::parse(detail::next_item(extensions, ','));
+            if (not offer) { continue; }
+            deflate_params params{
+                .server_no_context_takeover = offer->server_no_context_takeover or options.server_no_context_takeover,
+                .client_no_context_takeover = offer->client_no_context_takeover or options.client_no_context_takeover,
+                .server_max_window_bits = detail::compress_window_bits(
+                    std::min(options.server_max_window_bits, offer->server_max_window_bits.value_or(15))),
+                // the client window can only be limited when it offered client_max_window_bits
+                .client_max_window_bits = offer->client_max_window_bits_present
+                                              ? std::min(options.client_max_window_bits,
+                                                         offer->client_max_window_bits.value_or(15))
+                                              : 15,
+            };
+            // zlib cannot compress with 8 bits windows
+            if (offer->server_max_window_bits and params.server_max_window_bits > *offer->server_max_window_bits) {
+                continue;
+            }
+            if (detail::fit_memory(options.max_memory, params.server_max_window_bits, params.client_max_window_bits,
+                                   offer->client_max_window_bits_present)) {
+                return params;
+            }
+        }
+        return {};
+    }
+
+    /** @brief Client side negotiation: Sec-WebSocket-Extensions offer.
+     */
+    inline std::string deflate_offer(deflate_options const &options) {
+        int client_bits = detail::compress_window_bits(options.client_max_window_bits);
+        int server_bits = options.server_max_window_bits;
+        detail::fit_memory(options.max_memory, client_bits, server_bits, true);
+        deflate_params params{
+            .server_no_context_takeover = options.server_no_context_takeover,
+            .client_no_context_takeover = options.client_no_context_takeover,
+            .server_max_window_bits = server_bits,
+            .client_max_window_bits = client_bits,
+        };
+        auto value = params.to_string();
+        // let the server limit our window
+        if (client_bits == 15) { value += "; client_max_window_bits"; }
+        return value;
+    }
+
+    /** @brief Client side negotiation: check the server response to deflate_offer.
+     *
+     * @return nullopt when the server declined the extension.
+     * @throw std::system_error (protocol_error) on invalid responses.
+     */
+    inline std::optional<deflate_params> accept_deflate(deflate_options const &options, std::string_view response) {
+        if (detail::trim(response).empty()) { return {}; }
+        auto offer = detail::extension_offer::parse(response);
+        auto error = [] { return std::system_error{std::make_error_code(std::errc::protocol_error), "accept_deflate"}; };
+        if (not options.enabled or not offer or response.find(',') != std::string_view::npos
+            or (offer->client_max_window_bits_present and not offer->client_max_window_bits)) {
+            throw error();
+        }
+        int client_bits = detail::compress_window_bits(options.client_max_window_bits);
+        int server_bits = options.server_max_window_bits;
+        detail::fit_memory(options.max_memory, client_bits, server_bits, true);
+        deflate_params params{
+            .server_no_context_takeover = offer->server_no_context_takeover,
+            .client_no_context_takeover = offer->client_no_context_takeover or options.client_no_context_takeover,
+            .server_max_window_bits = offer->server_max_window_bits.value_or(15),
+            .client_max_window_bits = std::min(client_bits, offer->client_max_window_bits.value_or(15)),
+        };
+        if ((options.server_no_context_takeover and not params.server_no_context_takeover)
+            or params.server_max_window_bits > server_bits or params.client_max_window_bits < 9) {
+            throw error();
+        }
+        return params;
+    }
+
+    /** @brief permessage-deflate compressor/decompressor of a connection.
+     *
+     * zlib states are created on first use. Without context takeover, the compressor comes from
+     * the thread's web::deflater_pool for each message and no compression state is kept between messages.
+     */
+    class deflate_codec
+    {
+    public:
+        deflate_codec(deflate_params const &params, bool is_server, int level) noexcept
+            : level_{level},
+              deflate_window_bits_{
+                  detail::compress_window_bits(is_server ? params.server_max_window_bits : params.client_max_window_bits)},
+              inflate_window_bits_{detail::compress_window_bits(is_server ? params.client_max_window_bits
+                                                                          : params.server_max_window_bits)},
+              deflate_takeover_{not(is_server ? params.server_no_context_takeover : params.client_no_context_takeover)},
+              inflate_takeover_{not(is_server ? params.client_no_context_takeover : params.server_no_context_takeover)} {}
+
+        /** @brief Compress a whole message.
+         *
+         * @return Compressed payload, valid until the next call.
+         */
+        unifex::span<std::byte const> compress(unifex::span<std::byte const> message) {
+            web::deflater *d = nullptr;
+            if (deflate_takeover_) {
+                if (not deflater_) { deflater_.emplace(level_, -deflate_window_bits_); }
+                d = &*deflater_;
+            } else {
+                pooled_ = web::deflater_pool::local().acquire(level_, -deflate_window_bits_);
+                d = pooled_.get();
+            }
+            auto output = d->compress(message, Z_SYNC_FLUSH);
+            if (output.size() < 4) {
+                // nothing to flush (empty message): an empty block (RFC 7692 7.2.3.6)
+                return {empty_block, sizeof(empty_block)};
+            }
+            // trailing empty block (00 00 ff ff) is implied
+            return output.first(output.size() - 4);
+        }
+
+        /** @brief End of a sent message.
+         */
+        void end_compress() noexcept { pooled_.reset(); }
+
+        /** @brief Decompress the beginning of @a input (see web::inflater::decompress).
+         */
+        unifex::span<std::byte> decompress(unifex::span<std::byte const> &input, size_t max_output) {
+            if (not inflater_) { inflater_.emplace(-inflate_window_bits_); }
+            return inflater_->decompress(input, max_output);
+        }
+
+        [[nodiscard]] bool decompress_full() const noexcept { return inflater_ and inflater_->full(); }
+
+        /** @brief End of a received message (its trailing empty block has been decompressed).
+         */
+        void end_decompress() noexcept {
+            if (inflater_ and not inflate_takeover_) { inflater_->reset(); }
+        }
+
+        // trailing empty block, removed by senders
+        static constexpr std::byte tail[4] = {std::byte{0x00}, std::byte{0x00}, std::byte{0xff}, std::byte{0xff}};
+        static constexpr std::byte empty_block[1] = {std::byte{0x00}};
+
+    private:
+        int level_;
+        int deflate_window_bits_;
+        int inflate_window_bits_;
+        bool deflate_takeover_;
+        bool inflate_takeover_;
+        std::optional<web::deflater> deflater_{};
+        web::deflater_pool::pointer pooled_{};
+        std::optional<web::inflater> inflater_{};
+    };
+
+}// namespace g6::ws
@@ -8,7 +8,9 @@
 #include <cstring>
 
 #include <limits>
+#include <optional>
 #include <span>
+#include <string_view>
 #include <tuple>
 
 namespace g6::ws {
@@ -40,6 +42,58 @@ namespace g6::ws {
         tls_handshake_failure = 1015,
     };
 
+    /** @brief Status code that can be sent in a close frame.
+     *
+     * 1004, 1005 (no_status_code), 1006 (closed_abnormally) and 1015 (tls_handshake_failure) are reserved
+     * for local use, 1016-2999 are reserved for the protocol, 3000-4999 are registered/private codes.
+     */
+    constexpr bool is_valid_close_code(uint16_t code) noexcept {
+        return (code >= 1000 and code <= 1014 and code != 1004 and code != 1005 and code != 1006)
+            or (code >= 3000 and code <= 4999);
+    }
+
+    static_assert(is_valid_close_code(uint16_t(status_code::going_away)));
+    static_assert(not is_valid_close_code(uint16_t(status_code::no_status_code)));
+    static_assert(not is_valid_close_code(999) and not is_valid_close_code(1015) and is_valid_close_code(4000));
+
+    /** @brief Well-formed UTF-8 (no overlong encoding, surrogate or code point above U+10FFFF).
+     */
+    constexpr bool is_valid_utf8(std::string_view text) noexcept {
+        for (size_t ii = 0; ii < text.size();) {
+            const auto lead = uint8_t(text[ii]);
+            if (lead < 0x80) {
+                ++ii;
+                continue;
+            }
+            size_t length = 0;
+            // second byte range (overlongs, surrogates and out of range code points excluded)
+            uint8_t low = 0x80, high = 0xbf;
+            if (lead >= 0xc2 and lead <= 0xdf) {
+                length = 2;
+            } else if (lead >= 0xe0 and lead <= 0xef) {
+                length = 3;
+                if (lead == 0xe0) { low = 0xa0; }
+                if (lead == 0xed) { high = 0x9f; }
+            } else if (lead >= 0xf0 and lead <= 0xf4) {
+                length = 4;
+                if (lead == 0xf0) { low = 0x90; }
+                if (lead == 0xf4) { high = 0x8f; }
+            } else {
+                return false;
+            }
+            if (text.size() - ii < length) { return false; }
+            if (uint8_t second = uint8_t(text[ii + 1]); second < low or second > high) { return false; }
+            for (size_t jj = 2; jj < length; ++jj) {
+                if ((uint8_t(text[ii + jj]) & 0xc0) != 0x80) { return false; }
+            }
+            ii += length;
+        }
+        return true;
+    }
+
+    static_assert(is_valid_utf8("bye \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"));
+    static_assert(not is_valid_utf8("\xc0\xaf") and not is_valid_utf8("\xed\xa0\x80") and not is_valid_utf8("\xe2\x82"));
+
     struct header {
         bool fin = false;
         bool rsv1 = false, rsv2 = false, rsv3 = false;
@@ -51,6 +105,30 @@ namespace g6::ws {
 
         static constexpr size_t max_header_size = 14;
 
+        /** @brief Size of the header starting @a buffer, 0 when less than 2 bytes are available.
+         */
+        static size_t size(std::span<std::byte const> buffer) noexcept {
+            if (buffer.size() < 2) { return 0; }
+            size_t header_size = (buffer[1] & std::byte{0b1000'0000}) != std::byte{0} ? 6 : 2;
+            switch (uint8_t(buffer[1] & std::byte{0b0111'1111})) {
+                case 126:
+                    return header_size + 2;
+                case 127:
+                    return header_size + 8;
+                default:
+                    return header_size;
+            }
+        }
+
+        /** @brief Parse a possibly incomplete header.
+         *
+         * @return nullopt when @a buffer does not hold the whole header yet.
+         */
+        static std::optional<header> try_parse(std::span<std::byte const> buffer) {
+            if (auto header_size = size(buffer); header_size == 0 or buffer.size() < header_size) { return {}; }
+            return parse(buffer);
+        }
+
         static header parse(std::span<std::byte const> buffer) {
             header h{};
 
@@ -86,7 +164,7 @@ namespace g6::ws {
 
         void update_payload_offset() {
             size_t mask_offset = 2;
-            if (payload_length >= 127 && payload_length <= std::numeric_limits<uint16_t>::max()) {
+            if (payload_length >= 126 && payload_length <= std::numeric_limits<uint16_t>::max()) {
                 mask_offset = 4;
             } else if (payload_length > std::numeric_limits<uint16_t>::max()) {
                 mask_offset = 10;
@@ -113,7 +191,7 @@ namespace g6::ws {
                       | (std::byte(opcode) & std::byte(0b0000'1111));
             if (payload_length < 126) {
                 buffer[1] = std::byte(mask << 7u) | (std::byte(0b0111'1111) & std::byte(payload_length));
-            } else if (payload_length < std::numeric_limits<uint16_t>::max()) {
+            } else if (payload_length <= std::numeric_limits<uint16_t>::max()) {
                 buffer[1] = std::byte(mask << 7u) | std::byte(0b0111'1110);
                 uint16_t len = htons(payload_length);
                 std::memcpy(&buffer[2], &len, 2);
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <g6/web/gather.hpp>
+#include <g6/web/web_cpo.hpp>
+#include <g6/ws/connection.hpp>
+#include <g6/ws/header.hpp>
+
+#include <unifex/async_manual_reset_event.hpp>
+#include <unifex/scope_guard.hpp>
+#include <unifex/span.hpp>
+#include <unifex/task.hpp>
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace g6::ws {
+
+    /** @brief Encoded server frame (header and payload), shared between its receivers.
+     *
+     * The frame is encoded once and refcounted: publishing it to many connections does not copy it.
+     * Frames are immutable, so they can be shared between threads (eg.: the hubs of a sharded_server).
+     */
+    class shared_frame
+    {
+    public:
+        shared_frame() noexcept = default;
+
+        static shared_frame encode(span<std::byte const> payload, op_code opcode = op_code::text_frame) {
+            header h{.fin = true, .opcode = opcode, .payload_length = payload.size()};
+            std::array<std::byte, header::max_header_size> header_data{};
+            h.serialize(header_data);
+            shared_frame frame{};
+            frame.size_ = h.payload_offset + payload.size();
+            frame.data_ = std::make_shared_for_overwrite<std::byte[]>(frame.size_);
+            std::memcpy(frame.data_.get(), header_data.data(), h.payload_offset);
+            if (not payload.empty()) { std::memcpy(frame.data_.get() + h.payload_offset, payload.data(), payload.size()); }
+            return frame;
+        }
+
+        [[nodiscard]] span<std::byte const> bytes() const noexcept { return {data_.get(), size_}; }
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+        explicit operator bool() const noexcept { return bool(data_); }
+
+    private:
+        std::shared_ptr<std::byte[]> data_{};
+        size_t size_{0};
+    };
+
+    enum class overflow_policy
+    {
+        // the oldest queued frame is dropped
+        drop_oldest,
+        // the new frame is dropped
+        drop_newest,
+        // the subscriber is disconnected
+        disconnect,
+    };
+
+    struct hub_options {
+        // maximum number of frames queued for a subscriber
+        size_t max_queued_frames = 256;
+        // what happens when a subscriber queue is full (slow consumer)
+        overflow_policy overflow = overflow_policy::drop_oldest;
+    };
+
+    inline const hub_options default_hub_options{};
+
+    struct hub_stats {
+        // frames published (whatever their number of receivers)
+        size_t published = 0;
+        // frames queued for a subscriber
+        size_t queued = 0;
+        // frames dropped by the overflow policy
+        size_t dropped = 0;
+        // subscribers disconnected by the overflow policy or a send failure
+        size_t disconnected = 0;
+    };
+
+    /** @brief Topic based publish/subscribe over websocket server connections.
+     *
+     * Published messages are encoded once (see shared_frame) and queued for each subscriber.
+     * Each subscriber has its own bounded queue, written by its own coroutine (subscriber::async_run):
+     * slow consumers do not delay the others, their queue overflows instead (see overflow_policy).
+     * A subscriber's messages must all go through the hub (subscriber::send) so that frames are not interleaved.
+     * The hub is not thread-safe: use one hub per io context.
+     *
+     * @code
+     * ws::hub<ws::server_session<net::async_socket>> hub{};
+     * ...
+     * ws::hub<ws::server_session<net::async_socket>>::subscriber subscriber{hub, session};
+     * subscriber.join("news");
+     * co_await when_all(subscriber.async_run(), [&]() -> task<void> {
+     *     scope_guard _ = [&]() noexcept { subscriber.close(); };
+     *     // receive messages, hub.publish("news", ...)
+     * }());
+     * @endcode
+     */
+    template<typename Session>
+    class hub
+    {
+    public:
+        class subscriber
+        {
+        public:
+            subscriber(hub &hub, Session &session) : hub_{hub}, session_{session} {
+                self_ = hub_.subscribers_.insert(hub_.subscribers_.end(), this);
+            }
+
+            subscriber(subscriber const &) = delete;
+            subscriber &operator=(subscriber const &) = delete;
+
+            ~subscriber() noexcept {
+                for (auto &[topic, position] : topics_) { hub_.leave(topic, position); }
+                hub_.subscribers_.erase(self_);
+            }
+
+            void join(std::string_view topic) {
+                if (std::find_if(topics_.begin(), topics_.end(), [&](auto const &t) { return t.first == topic; })
+                    != topics_.end()) {
+                    return;
+                }
+                auto &receivers = hub_.topics_.try_emplace(std::string{topic}).first->second;
+                topics_.emplace_back(std::string{topic}, receivers.insert(receivers.end(), this));
+            }
+
+            void leave(std::string_view topic) noexcept {
+                auto it = std::find_if(topics_.begin(), topics_.end(), [&](auto const &t) { return t.first == topic; });
+                if (it != topics_.end()) {
+                    hub_.leave(it->first, it->second);
+                    topics_.erase(it);
+                }
+            }
+
+            /** @brief Queue @a frame, applying the overflow policy.
+             *
+             * @return false when the frame has not been queued (closed subscriber, full queue).
+             */
+            bool push(shared_frame frame) {
+                if (closed_) { return false; }
+                if (queue_.size() >= hub_.options_.max_queued_frames) {
+                    ++hub_.stats_.dropped;
+                    switch (hub_.options_.overflow) {
+                        case overflow_policy::drop_oldest:
+                            queue_.pop_front();
+                            break;
+                        case overflow_policy::drop_newest:
+                            return false;
+                        case overflow_policy::disconnect:
+                            disconnect();
+                            return false;
+                    }
+                }
+                queue_.push_back(std::move(frame));
+                ++hub_.stats_.queued;
+                ready_.set();
+                return true;
+            }
+
+            /** @brief Queue a message for this subscriber only.
+             */
+            bool send(span<std::byte const> payload, op_code opcode = op_code::text_frame) {
+                return push(shared_frame::encode(payload, opcode));
+            }
+
+            /** @brief Write queued frames until the subscriber is closed.
+             *
+             * Send failures close the subscriber.
+             */
+            task<void> async_run() {
+                while (true) {
+                    while (queue_.empty() and not closed_) {
+                        co_await ready_.async_wait();
+                        ready_.reset();
+                    }
+                    if (closed_) { break; }
+                    auto frame = std::move(queue_.front());
+                    queue_.pop_front();
+                    try {
+                        co_await async_send_frame(session_, frame.bytes());
+                    } catch (std::system_error const &) {
+                        disconnect();
+                    }
+                }
+            }
+
+            /** @brief Stop async_run, queued frames are discarded.
+             */
+            void close() noexcept {
+                closed_ = true;
+                queue_.clear();
+                ready_.set();
+            }
+
+            [[nodiscard]] bool closed() const noexcept { return closed_; }
+            [[nodiscard]] size_t queued() const noexcept { return queue_.size(); }
+            [[nodiscard]] Session &session() noexcept { return session_; }
+
+        private:
+            // close, and shut the connection down so that its pending receive fails
+            void disconnect() noexcept {
+                if (closed_) { return; }
+                ++hub_.stats_.disconnected;
+                close();
+                auto &socket = web::get_socket(session_);
+                if constexpr (requires { socket.native_handle(); }) { ::shutdown(socket.native_handle(), SHUT_RDWR); }
+            }
+
+            hub &hub_;
+            Session &session_;
+            typename std::list<subscriber *>::iterator self_;
+            std::vector<std::pair<std::string, typename std::list<subscriber *>::iterator>> topics_{};
+            std::deque<shared_frame> queue_{};
+            async_manual_reset_event ready_{};
+            bool closed_{false};
+        };
+
+        explicit hub(hub_options const &options = default_hub_options) : options_{options} {}
+
+        hub(hub const &) = delete;
+
+        [[nodiscard]] hub_stats const &statistics() const noexcept { return stats_; }
+        [[nodiscard]] size_t size() const noexcept { return subscribers_.size(); }
+
+        /** @brief Queue @a frame for the subscribers of @a topic (but @a excluded).
+         *
+         * @return Number of subscribers the frame has been queued for.
+         */
+        size_t publish(std::string_view topic, shared_frame const &frame, subscriber const *excluded = nullptr) {
+            ++stats_.published;
+            auto it = topics_.find(topic);
+            return it == topics_.end() ? 0 : push(it->second, frame, excluded);
+        }
+
+        size_t publish(std::string_view topic, span<std::byte const> payload, subscriber const *excluded = nullptr,
+                       op_code opcode = op_code::text_frame) {
+            return publish(topic, shared_frame::encode(payload, opcode), excluded);
+        }
+
+        /** @brief Queue @a frame for all subscribers (but @a excluded).
+         */
+        size_t broadcast(shared_frame const &frame, subscriber const *excluded = nullptr) {
+            ++stats_.published;
+            return push(subscribers_, frame, excluded);
+        }
+
+        size_t broadcast(span<std::byte const> payload, subscriber const *excluded = nullptr,
+                         op_code opcode = op_code::text_frame) {
+            return broadcast(shared_frame::encode(payload, opcode), excluded);
+        }
+
+    private:
+        size_t push(std::list<subscriber *> const &receivers, shared_frame const &frame, subscriber const *excluded) {
+            size_t count = 0;
+            for (auto *receiver : receivers) {
+                if (receiver != excluded and receiver->push(frame)) { ++count; }
+            }
+            return count;
+        }
+
+        void leave(std::string const &topic, typename std::list<subscriber *>::iterator position) noexcept {
+            auto it = topics_.find(topic);
+            it->second.erase(position);
+            if (it->second.empty()) { topics_.erase(it); }
+        }
+
+        hub_options options_;
+        hub_stats stats_{};
+        std::list<subscriber *> subscribers_{};
+        std::map<std::string, std::list<subscriber *>, std::less<>> topics_{};
+    };
+
+}// namespace g6::ws
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <unifex/span.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace g6::ws {
+
+    /** @brief Apply a frame masking key (RFC 6455 5.3).
+     *
+     * Masking and unmasking are the same operation, @a output might be @a input (in place).
+     * The payload can be processed in parts: @a key_offset is the payload position of input[0] (modulo 4).
+     *
+     * @param masking_key Key, as stored in the frame header (wire byte order).
+     * @param output      At least input.size() bytes.
+     * @return Key offset of the byte following @a input.
+     */
+    size_t apply_mask(unifex::span<std::byte const> input, unifex::span<std::byte> output, uint32_t masking_key,
+                      size_t key_offset = 0) noexcept;
+
+    inline size_t apply_mask(unifex::span<std::byte> data, uint32_t masking_key, size_t key_offset = 0) noexcept {
+        return apply_mask(unifex::span<std::byte const>{data.data(), data.size()}, data, masking_key, key_offset);
+    }
+
+}// namespace g6::ws
@@ -11,6 +11,9 @@ namespace g6 {
     namespace web {
         template<typename Context>
         auto tag_invoke(tag_t<make_server>, Context &ctx, web::proto::ws_ const &, net::ip_endpoint endpoint);
+
+        template<typename Context>
+        auto tag_invoke(tag_t<make_server>, Context &ctx, web::proto::ws_ const &, net::async_socket socket);
     }
 
     namespace ws {
@@ -19,8 +22,10 @@ namespace g6 {
         {
         public:
             explicit server_session(Socket &&socket, net::ip_endpoint const& endpoint,
-                                    uint32_t version = connection<true, Socket>::max_ws_version_) noexcept
-                : connection<true, Socket>{std::forward<Socket>(socket), endpoint, version} {}
+                                    uint32_t version = connection<true, Socket>::max_ws_version_,
+                                    connection_options const &options = default_connection_options,
+                                    std::optional<deflate_params> const &deflate = {}) noexcept
+                : connection<true, Socket>{std::forward<Socket>(socket), endpoint, version, options, deflate} {}
         };
 
         template<typename Context, typename Socket>
@@ -29,13 +34,23 @@ namespace g6 {
         public:
             static constexpr auto proto = web::proto::ws;
 
+            /** @brief Options of the upgraded connections.
+             */
+            auto &upgrade_options() noexcept { return upgrade_options_; }
+
         private:
+            connection_options upgrade_options_{};
+
             server(Context &context, Socket socket) noexcept
                 : g6::http::server<Context, Socket>{context, std::move(socket)} {}
 
             template<typename Context_>
             friend auto web::tag_invoke(tag_t<web::make_server>, Context_ &ctx, web::proto::ws_ const &,
                                         net::ip_endpoint endpoint);
+
+            template<typename Context_>
+            friend auto web::tag_invoke(tag_t<web::make_server>, Context_ &ctx, web::proto::ws_ const &,
+                                        net::async_socket socket);
         };
     }// namespace ws
 
@@ -51,15 +66,22 @@ namespace g6 {
         template<typename Socket>
         task<ws::server_session<Socket>> tag_invoke(tag_t<web::upgrade_connection>, web::proto::ws_,
                                                     http::server_session<Socket> &http_session,
-                                                    http::server_request<Socket> &request) {
+                                                    ws::connection_options const &options) {
+            auto request = co_await net::async_recv(http_session);
+            co_return co_await web::upgrade_connection(web::proto::ws, http_session, request, options);
+        }
+
+        template<typename Socket>
+        task<ws::server_session<Socket>> tag_invoke(tag_t<web::upgrade_connection>, web::proto::ws_,
+                                                    http::server_session<Socket> &http_session,
+                                                    http::server_request<Socket> &request,
+                                                    ws::connection_options const &options = ws::default_connection_options) {
             while (net::has_pending_data(request)) { co_await net::async_recv(request); }
 #ifdef G6_WEB_DEBUG
             for (auto &h : request.headers()) { spdlog::debug("{} -> {}", h.first, h.second); }
 #endif
-            auto con_header = request.header("Connection");
-            auto upgrade_header = request.header("Upgrade");
-            bool upgrade = con_header.find("Upgrade") != std::string::npos;
-            bool websocket = upgrade_header == "websocket";
+            bool upgrade = http::has_token(request.header(http::header_id::connection), "upgrade");
+            bool websocket = http::detail::iequals(request.header(http::header_id::upgrade), "websocket");
 
             if (not upgrade or not websocket) {
                 spdlog::warn("got a non-websocket connection");
@@ -68,21 +90,24 @@ namespace g6 {
             }
 
             uint32_t ws_version = ws::server_session<Socket>::max_ws_version_;
-            if (auto const &version = request.header("Sec-WebSocket-Version"); not version.empty()) {
+            if (auto version = request.header(http::header_id::sec_websocket_version); not version.empty()) {
                 std::from_chars(version.data(), version.data() + version.size(), ws_version);
             }
-            auto &accept = request.header("Sec-WebSocket-Key");
-            accept = crypto::base64::encode(crypto::sha1::hash(accept, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+            auto accept = crypto::base64::encode(crypto::sha1::hash(request.header(http::header_id::sec_websocket_key),
+                                                                    "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
 #ifdef G6_WEB_DEBUG
             spdlog::debug("accept-hash: {}", accept);
 #endif
             http::headers hdrs{{"Upgrade", "websocket"},
                                {"Connection", "Upgrade"},
                                {"Sec-WebSocket-Accept", std::move(accept)}};
+            auto deflate = ws::negotiate_deflate(options.deflate, request.header(http::header_id::sec_websocket_extensions));
+            if (deflate) { hdrs.emplace("Sec-WebSocket-Extensions", deflate->to_string()); }
             std::string_view dumb{};
             co_await net::async_send(http_session, http::status::switching_protocols, std::move(hdrs),
                                      as_bytes(span{dumb.data(), dumb.size()}));
-            co_return ws::server_session<Socket>{std::move(web::get_socket(http_session)), http_session.remote_endpoint(), ws_version};
+            co_return ws::server_session<Socket>{std::move(web::get_socket(http_session)), http_session.remote_endpoint(),
+                                                 ws_version, options, deflate};
         }
     }// namespace http
 
@@ -92,5 +117,10 @@ namespace g6 {
             auto socket = net::open_socket(ctx, net::tcp_server, std::move(endpoint));
             return ws::server{ctx, std::move(socket)};
         }
+
+        template<typename Context>
+        auto tag_invoke(tag_t<make_server>, Context &ctx, web::proto::ws_ const &, net::async_socket socket) {
+            return ws::server{ctx, std::move(socket)};
+        }
     }// namespace web
 }// namespace g6
@@ -1 +1,174 @@
 #include <g6/web/uri.hpp>
+
+#include <bit>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Percent-encoding kernels: runs of bytes that need no conversion are scanned and copied 32 (AVX2)
+// or 16 (SSE2) bytes at a time into the preallocated output.
+
+namespace g6::web {
+
+namespace {
+
+constexpr bool is_unreserved(char c) noexcept {
+  return (c >= '0' and c <= '9') or (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z');
+}
+
+constexpr int hex_value(char c) noexcept {
+  if (c >= '0' and c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' and c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' and c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+#if defined(__AVX2__)
+// bitmask of the [a-zA-Z0-9] bytes
+inline uint32_t unreserved_mask(__m256i chunk) noexcept {
+  // bytes >= 0x80 are negative: never in range
+  const __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+  const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+  const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+  return uint32_t(_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)));
+}
+#endif
+
+#if defined(__SSE2__)
+inline uint32_t unreserved_mask(__m128i chunk) noexcept {
+  const __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+  const __m128i digit =
+      _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+  const __m128i alpha =
+      _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+  return uint32_t(_mm_movemask_epi8(_mm_or_si128(digit, alpha)));
+}
+#endif
+
+// Copy bytes to @a out up to the first one that must be escaped.
+// Whole chunks are stored: @a out must have room for a chunk while a chunk is left in the input.
+void copy_unreserved(const char *&in, const char *end, char *&out) noexcept {
+#if defined(__AVX2__)
+  for (; end - in >= 32; in += 32, out += 32) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), chunk);
+    if (const auto mask = ~unreserved_mask(chunk); mask != 0) {
+      const auto count = std::countr_zero(mask);
+      in += count;
+      out += count;
+      return;
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  for (; end - in >= 16; in += 16, out += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), chunk);
+    if (const auto mask = ~unreserved_mask(chunk) & 0xffffu; mask != 0) {
+      const auto count = std::countr_zero(mask);
+      in += count;
+      out += count;
+      return;
+    }
+  }
+#endif
+  while (in != end and is_unreserved(*in)) {
+    *out++ = *in++;
+  }
+}
+
+// Copy bytes to @a out up to the first '%' (or '+' when decoded as space), same requirements as copy_unreserved.
+void copy_unescaped(const char *&in, const char *end, char *&out, bool plus_as_space) noexcept {
+#if defined(__AVX2__)
+  const __m256i percent32 = _mm256_set1_epi8('%');
+  const __m256i plus32 = _mm256_set1_epi8(plus_as_space ? '+' : '%');
+  for (; end - in >= 32; in += 32, out += 32) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), chunk);
+    const auto mask = uint32_t(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, percent32), _mm256_cmpeq_epi8(chunk, plus32))));
+    if (mask != 0) {
+      const auto count = std::countr_zero(mask);
+      in += count;
+      out += count;
+      return;
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i percent16 = _mm_set1_epi8('%');
+  const __m128i plus16 = _mm_set1_epi8(plus_as_space ? '+' : '%');
+  for (; end - in >= 16; in += 16, out += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), chunk);
+    const auto mask =
+        uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, percent16), _mm_cmpeq_epi8(chunk, plus16))));
+    if (mask != 0) {
+      const auto count = std::countr_zero(mask);
+      in += count;
+      out += count;
+      return;
+    }
+  }
+#endif
+  while (in != end and *in != '%' and not(plus_as_space and *in == '+')) {
+    *out++ = *in++;
+  }
+}
+
+} // namespace
+
+void uri::escape(std::string_view input, std::string &output) {
+  static constexpr char hex_digits[] = "0123456789ABCDEF";
+  const size_t offset = output.size();
+  // worst case: every byte escaped
+  output.resize(offset + 3 * input.size());
+  char *out = output.data() + offset;
+  const char *in = input.data();
+  const char *end = in + input.size();
+  while (true) {
+    copy_unreserved(in, end, out);
+    if (in == end) {
+      break;
+    }
+    const auto c = uint8_t(*in++);
+    *out++ = '%';
+    *out++ = hex_digits[c >> 4];
+    *out++ = hex_digits[c & 0xf];
+  }
+  output.resize(size_t(out - output.data()));
+}
+
+void uri::unescape(std::string_view input, std::string &output, bool plus_as_space) {
+  const size_t offset = output.size();
+  // decoded output is never larger
+  output.resize(offset + input.size());
+  char *out = output.data() + offset;
+  const char *in = input.data();
+  const char *end = in + input.size();
+  while (true) {
+    copy_unescaped(in, end, out, plus_as_space);
+    if (in == end) {
+      break;
+    }
+    if (*in == '+') {
+      *out++ = ' ';
+      ++in;
+    } else if (int high, low; end - in >= 3 and (high = hex_value(in[1])) >= 0 and (low = hex_value(in[2])) >= 0) {
+      *out++ = char((high << 4) | low);
+      in += 3;
+    } else {
+      *out++ = *in++;
+    }
+  }
+  output.resize(size_t(out - output.data()));
+}
+
+} // namespace g6::web
@@ -0,0 +1,61 @@
+#include <g6/ws/mask.hpp>
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// XOR 64 (AVX-512), 32 (AVX2) or 16 (SSE2) bytes per step with the key repeated (and rotated to the
+// payload position), then 8 bytes per step and a scalar tail.
+
+namespace g6::ws {
+
+size_t apply_mask(unifex::span<std::byte const> input, unifex::span<std::byte> output, uint32_t masking_key,
+                  size_t key_offset) noexcept {
+  std::byte key[4];
+  std::memcpy(key, &masking_key, 4);
+  std::byte const *in = input.data();
+  std::byte *out = output.data();
+  size_t size = input.size();
+  const size_t end_offset = (key_offset + size) & 3;
+
+  // rotate the key, so that it starts at in[0]
+  std::byte rotated[4];
+  for (size_t ii = 0; ii < 4; ++ii) { rotated[ii] = key[(key_offset + ii) & 3]; }
+  uint32_t key32 = 0;
+  std::memcpy(&key32, rotated, 4);
+
+#if defined(__AVX512F__)
+  const __m512i key512 = _mm512_set1_epi32(int(key32));
+  for (; size >= 64; size -= 64, in += 64, out += 64) {
+    _mm512_storeu_si512(out, _mm512_xor_si512(_mm512_loadu_si512(in), key512));
+  }
+#endif
+#if defined(__AVX2__)
+  const __m256i key256 = _mm256_set1_epi32(int(key32));
+  for (; size >= 32; size -= 32, in += 32, out += 32) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                        _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in)), key256));
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i key128 = _mm_set1_epi32(int(key32));
+  for (; size >= 16; size -= 16, in += 16, out += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in)), key128));
+  }
+#endif
+  const uint64_t key64 = uint64_t(key32) | (uint64_t(key32) << 32);
+  for (; size >= 8; size -= 8, in += 8, out += 8) {
+    uint64_t chunk = 0;
+    std::memcpy(&chunk, in, 8);
+    chunk ^= key64;
+    std::memcpy(out, &chunk, 8);
+  }
+  // steps are multiple of 4: the key is still aligned on in[0]
+  for (size_t ii = 0; ii < size; ++ii) { out[ii] = in[ii] ^ rotated[ii & 3]; }
+  return end_offset;
+}
+
+} // namespace g6::ws
@@ -5,13 +5,26 @@
 #include <g6/web/web_cpo.hpp>
 
 #include <g6/http/client.hpp>
+#include <g6/http/client_pool.hpp>
+#include <g6/http/content_encoding.hpp>
+#include <g6/http/file_sink.hpp>
+#include <g6/http/response_cache.hpp>
+#include <g6/http/router.hpp>
 #include <g6/http/server.hpp>
+#include <g6/http/static_file.hpp>
 #include <g6/io/context.hpp>
+#include <g6/web/sharded_server.hpp>
 
 #include <unifex/sync_wait.hpp>
 #include <unifex/task.hpp>
 #include <unifex/when_all.hpp>
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
 using namespace g6;
 
 TEST_CASE("http simple server", "[g6::net::http]") {
@@ -28,7 +41,7 @@ TEST_CASE("http simple server", "[g6::net::http]") {
                 return [&session]<typename Request>(Request request) -> task<void> {
                     while (net::has_pending_data(request)) {
                         auto body = co_await net::async_recv(request);
-                        auto sv_body = std::string_view{reinterpret_cast<char *>(body.data()), body.size()};
+                        auto sv_body = std::string_view{reinterpret_cast<const char *>(body.data()), body.size()};
                         spdlog::info("body: {}", sv_body);
                         REQUIRE(sv_body == "Hello !");
                     }
@@ -55,3 +68,1054 @@ TEST_CASE("http simple server", "[g6::net::http]") {
             co_return;
         }()));
 }
+
+TEST_CASE("http keep-alive", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    server.options().max_requests_per_connection = 3;
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    size_t connection_count = 0;
+    size_t request_count = 0;
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                ++connection_count;
+                return [&session, &request_count]<typename Request>(Request request) -> task<void> {
+                    ++request_count;
+                    // body is left unread: the server must drain it
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{"OK !", 4}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            for (int ii = 0; ii < 3; ++ii) {
+                auto response = co_await net::async_send(client, "/", http::method::post, as_bytes(span{"Hello !", 7}));
+                std::string body_str;
+                while (net::has_pending_data(response)) {
+                    auto body = co_await net::async_recv(response);
+                    body_str += std::string_view{reinterpret_cast<char *>(body.data()), body.size()};
+                }
+                REQUIRE(response.status_code() == http::status::ok);
+                REQUIRE(body_str == "OK !");
+                REQUIRE(response.keep_alive() == (ii != 2));
+            }
+            REQUIRE(connection_count == 1);
+            REQUIRE(request_count == 3);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http pipelining", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    auto const &path = request.url();
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{path.data(), path.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto sock = net::open_socket(ctx, net::tcp_client);
+            co_await net::async_connect(sock, server_endpoint);
+            std::string_view requests = "GET /first HTTP/1.1\r\n\r\n"
+                                        "POST /second HTTP/1.1\r\nContent-Length: 7\r\n\r\nHello !"
+                                        "GET /third HTTP/1.1\r\nConnection: close\r\n\r\n";
+            co_await net::async_send(sock, as_bytes(span{requests.data(), requests.size()}));
+            std::string responses;
+            std::array<char, 1024> buffer{};
+            while (size_t bytes = co_await net::async_recv(sock, as_writable_bytes(span{buffer}))) {
+                responses.append(buffer.data(), bytes);
+            }
+            auto first = responses.find("/first");
+            auto second = responses.find("/second");
+            auto third = responses.find("/third");
+            REQUIRE(first != std::string::npos);
+            REQUIRE(second != std::string::npos);
+            REQUIRE(third != std::string::npos);
+            REQUIRE(first < second);
+            REQUIRE(second < third);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http pipelining partial request", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    server.options().idle_timeout = std::chrono::seconds{2};
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    auto const &path = request.url();
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{path.data(), path.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto sock = net::open_socket(ctx, net::tcp_client);
+            co_await net::async_connect(sock, server_endpoint);
+            // the second request never completes: the first response must not wait for it (nor for the idle timeout)
+            std::string_view requests = "GET /first HTTP/1.1\r\n\r\n"
+                                        "GET /sec";
+            auto start = std::chrono::steady_clock::now();
+            co_await net::async_send(sock, as_bytes(span{requests.data(), requests.size()}));
+            std::string responses;
+            std::array<char, 1024> buffer{};
+            while (responses.find("/first") == std::string::npos) {
+                size_t bytes = co_await net::async_recv(sock, as_writable_bytes(span{buffer}));
+                REQUIRE(bytes != 0);
+                responses.append(buffer.data(), bytes);
+            }
+            REQUIRE(std::chrono::steady_clock::now() - start < server.options().idle_timeout);
+            REQUIRE(responses.starts_with("HTTP/1.1 200"));
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http large header", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    const std::string cookie(8000, 'c');
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &cookie]<typename Request>(Request request) -> task<void> {
+                    REQUIRE(request.header("Cookie") == cookie);
+                    co_await net::async_send(session, http::status::ok);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            http::headers headers{{"Cookie", cookie}};
+            auto response = co_await net::async_send(client, "/", http::method::get, std::move(headers));
+            while (net::has_pending_data(response)) { co_await net::async_recv(response); }
+            REQUIRE(response.status_code() == http::status::ok);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http sharded server", "[g6::net::http]") {
+    inplace_stop_source stop_source{};
+
+    web::sharded_server<io::context, web::proto::http_> server{
+        web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"), 2};
+    REQUIRE(server.size() == 2);
+    auto server_endpoint = server.local_endpoint();
+    std::atomic_size_t request_count = 0;
+
+    std::jthread server_thread{[&] {
+        server.serve(stop_source, [&](size_t, io::context &) {
+            return [&]<typename Session>(Session &session) {
+                return [&session, &request_count]<typename Request>(Request request) -> task<void> {
+                    ++request_count;
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{"OK !", 4}));
+                };
+            };
+        });
+    }};
+
+    io::context ctx{};
+    inplace_stop_source client_stop_source{};
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { client_stop_source.request_stop(); };
+            for (int ii = 0; ii < 8; ++ii) {
+                auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+                auto response = co_await net::async_send(client, "/", http::method::get);
+                std::string body_str;
+                while (net::has_pending_data(response)) {
+                    auto body = co_await net::async_recv(response);
+                    body_str += std::string_view{reinterpret_cast<char *>(body.data()), body.size()};
+                }
+                REQUIRE(response.status_code() == http::status::ok);
+                REQUIRE(body_str == "OK !");
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(client_stop_source.get_token());
+            co_return;
+        }()));
+
+    stop_source.request_stop();
+    server_thread.join();
+    REQUIRE(request_count == 8);
+}
+
+TEST_CASE("http headers split between receives", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    std::string body;
+                    while (net::has_pending_data(request)) {
+                        auto data = co_await net::async_recv(request);
+                        body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                    }
+                    // headers must have survived the receive buffer reuse
+                    REQUIRE(request.header("x-custom-header") == "first-part-second-part");
+                    REQUIRE(request.header("HOST") == "localhost");
+                    REQUIRE(request.header("Missing").empty());
+                    REQUIRE(body == "Hello !");
+                    co_await net::async_send(session, http::status::ok);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto sock = net::open_socket(ctx, net::tcp_client);
+            co_await net::async_connect(sock, server_endpoint);
+            for (std::string_view part : {"POST / HTTP/1.1\r\nHost: localhost\r\nX-Custom-He",
+                                          "ader: first-part-", "second-part\r\nContent-Length: 7\r\n\r\nHel",
+                                          "lo !"}) {
+                co_await net::async_send(sock, as_bytes(span{part.data(), part.size()}));
+                auto sched = ctx.get_scheduler();
+                co_await schedule_at(sched, now(sched) + std::chrono::milliseconds{10});
+            }
+            std::array<char, 1024> buffer{};
+            size_t bytes = co_await net::async_recv(sock, as_writable_bytes(span{buffer}));
+            REQUIRE(std::string_view{buffer.data(), bytes}.starts_with("HTTP/1.1 200"));
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http case-insensitive headers", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    REQUIRE(request.header(http::header_id::content_length) == "7");
+                    REQUIRE(request.header(http::header_id::host) == "localhost");
+                    REQUIRE(request.header("X-Lower") == "value");
+                    std::string body;
+                    while (net::has_pending_data(request)) {
+                        auto data = co_await net::async_recv(request);
+                        body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                    }
+                    REQUIRE(body == "Hello !");
+                    co_await net::async_send(session, http::status::ok);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto sock = net::open_socket(ctx, net::tcp_client);
+            co_await net::async_connect(sock, server_endpoint);
+            std::string_view request = "POST / HTTP/1.1\r\nhost: localhost\r\nx-lower: value\r\n"
+                                       "content-length: 7\r\nconnection: close\r\n\r\nHello !";
+            co_await net::async_send(sock, as_bytes(span{request.data(), request.size()}));
+            std::array<char, 1024> buffer{};
+            size_t bytes = co_await net::async_recv(sock, as_writable_bytes(span{buffer}));
+            REQUIRE(std::string_view{buffer.data(), bytes}.starts_with("HTTP/1.1 200"));
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http chunked response", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    const std::string chunk(1024, 'c');
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &chunk]<typename Request>(Request request) -> task<void> {
+                    http::headers headers{{"Transfer-Encoding", "chunked"}};
+                    auto response = co_await net::async_send(session, http::status::ok, std::move(headers));
+                    for (int ii = 0; ii < 10; ++ii) {
+                        co_await net::async_send(response, as_bytes(span{chunk.data(), chunk.size()}));
+                    }
+                    co_await net::async_send(response);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            for (int ii = 0; ii < 2; ++ii) {
+                auto response = co_await net::async_send(client, "/", http::method::get);
+                size_t received = 0;
+                while (net::has_pending_data(response)) {
+                    auto body = co_await net::async_recv(response);
+                    received += body.size();
+                }
+                REQUIRE(response.status_code() == http::status::ok);
+                REQUIRE(response.chunked());
+                REQUIRE(received == 10 * chunk.size());
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http file body", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    auto path = std::filesystem::temp_directory_path() / "g6-http-file-body-test.bin";
+    std::string content(3 * 1024 * 1024 + 17, '\0');
+    for (size_t ii = 0; ii < content.size(); ++ii) { content[ii] = char(ii % 251); }
+    std::ofstream{path, std::ios::binary}.write(content.data(), std::streamsize(content.size()));
+    scope_guard remove_file = [&]() noexcept { std::filesystem::remove(path); };
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &path]<typename Request>(Request request) -> task<void> {
+                    http::file_body file{path};
+                    co_await net::async_send(session, http::status::ok, http::headers{}, file);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            auto response = co_await net::async_send(client, "/", http::method::get);
+            std::string body;
+            while (net::has_pending_data(response)) {
+                auto data = co_await net::async_recv(response);
+                body.append(reinterpret_cast<char const *>(data.data()), data.size());
+            }
+            REQUIRE(response.status_code() == http::status::ok);
+            REQUIRE(response.header(http::header_id::content_length) == std::to_string(content.size()));
+            REQUIRE(body == content);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http static file", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    auto path = std::filesystem::temp_directory_path() / "g6-http-static-file-test.txt";
+    const std::string content = "0123456789abcdefghijklmnopqrstuvwxyz";
+    std::ofstream{path} << content;
+    scope_guard remove_file = [&]() noexcept { std::filesystem::remove(path); };
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &path]<typename Request>(Request request) -> task<void> {
+                    co_await http::async_send_static_file(session, request, path);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            auto get = [&](http::headers headers, http::method method = http::method::get)
+                -> task<std::tuple<http::status, std::string, std::string>> {
+                auto response = co_await net::async_send(client, "/", method, std::move(headers));
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                co_return std::tuple{response.status_code(), std::string{response.header(http::header_id::etag)},
+                                     std::move(body)};
+            };
+
+            auto [status, etag, body] = co_await get({});
+            REQUIRE(status == http::status::ok);
+            REQUIRE(body == content);
+            REQUIRE(not etag.empty());
+
+            http::headers if_none_match{{"If-None-Match", etag}};
+            auto [not_modified, etag2, empty] = co_await get(std::move(if_none_match));
+            REQUIRE(not_modified == http::status::not_modified);
+            REQUIRE(etag2 == etag);
+            REQUIRE(empty.empty());
+
+            // conditional headers only apply to GET and HEAD
+            http::headers post_if_none_match{{"If-None-Match", etag}};
+            auto [post_status, post_etag, post_body] = co_await get(std::move(post_if_none_match), http::method::post);
+            REQUIRE(post_status == http::status::ok);
+            REQUIRE(post_body == content);
+
+            http::headers single{{"Range", "bytes=2-5"}};
+            auto [partial, etag3, part] = co_await get(std::move(single));
+            REQUIRE(partial == http::status::partial_content);
+            REQUIRE(part == "2345");
+
+            http::headers multiple{{"Range", "bytes=0-1,-2"}};
+            auto [multipart, etag4, parts] = co_await get(std::move(multiple));
+            REQUIRE(multipart == http::status::partial_content);
+            REQUIRE(parts.find("Content-Range: bytes 0-1/36\r\n\r\n01\r\n") != std::string::npos);
+            REQUIRE(parts.find("Content-Range: bytes 34-35/36\r\n\r\nyz\r\n") != std::string::npos);
+
+            http::headers unsatisfiable{{"Range", "bytes=100-"}};
+            auto [range_error, etag5, nothing] = co_await get(std::move(unsatisfiable));
+            REQUIRE(range_error == http::status::range_not_satisfiable);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http response cache", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    http::response_cache cache{};
+
+    auto path = std::filesystem::temp_directory_path() / "g6-http-response-cache-test.json";
+    const std::string content = R"({"cached":true})";
+    std::ofstream{path} << content;
+    scope_guard remove_file = [&]() noexcept { std::filesystem::remove(path); };
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &path, &cache]<typename Request>(Request request) -> task<void> {
+                    co_await http::async_send_cached_file(cache, session, request, path);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            for (int ii = 0; ii < 3; ++ii) {
+                auto response = co_await net::async_send(client, "/", http::method::get);
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                REQUIRE(response.status_code() == http::status::ok);
+                REQUIRE(response.header(http::header_id::content_type) == "application/json");
+                REQUIRE(body == content);
+            }
+            REQUIRE(cache.statistics().misses == 1);
+            REQUIRE(cache.statistics().hits == 2);
+            REQUIRE(cache.statistics().entries == 1);
+            // missing precompressed siblings are cached (negative entries) but not counted
+            http::headers accept_encoding{{"Accept-Encoding", "br, gzip"}};
+            auto response = co_await net::async_send(client, "/", http::method::get, std::move(accept_encoding));
+            while (net::has_pending_data(response)) { co_await net::async_recv(response); }
+            REQUIRE(response.status_code() == http::status::ok);
+            REQUIRE(cache.statistics().misses == 1);
+            REQUIRE(cache.statistics().hits == 3);
+            REQUIRE(cache.statistics().entries == 3);
+            std::string etag{response.header(http::header_id::etag)};
+            // revalidation is answered from the cache, with the representation variance
+            http::headers if_none_match{{"If-None-Match", etag}};
+            auto not_modified = co_await net::async_send(client, "/", http::method::get, std::move(if_none_match));
+            while (net::has_pending_data(not_modified)) { co_await net::async_recv(not_modified); }
+            REQUIRE(not_modified.status_code() == http::status::not_modified);
+            REQUIRE(not_modified.header(http::header_id::vary) == "Accept-Encoding");
+            REQUIRE(cache.statistics().hits == 4);
+            // other methods are not served from the cache
+            http::headers post_if_none_match{{"If-None-Match", etag}};
+            auto post = co_await net::async_send(client, "/", http::method::post, std::move(post_if_none_match));
+            std::string body;
+            while (net::has_pending_data(post)) {
+                auto data = co_await net::async_recv(post);
+                body.append(reinterpret_cast<char const *>(data.data()), data.size());
+            }
+            REQUIRE(post.status_code() == http::status::ok);
+            REQUIRE(body == content);
+            REQUIRE(cache.statistics().hits == 4);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http response encoding", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    std::string json = "[";
+    for (int ii = 0; ii < 200; ++ii) { json += fmt::format(R"({{"id":{},"name":"item-{}"}},)", ii, ii); }
+    json.back() = ']';
+
+    auto path = std::filesystem::temp_directory_path() / "g6-http-encoding-test.txt";
+    std::ofstream{path} << "plain";
+    auto gz_path = path;
+    gz_path += ".gz";
+    std::ofstream{gz_path} << "precompressed";
+    scope_guard remove_files = [&]() noexcept {
+        std::filesystem::remove(path);
+        std::filesystem::remove(gz_path);
+    };
+
+    auto inflate = [](std::string const &input) {
+        z_stream stream{};
+        REQUIRE(inflateInit2(&stream, 31) == Z_OK);
+        std::string output(64 * 1024, '\0');
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+        stream.avail_in = uInt(input.size());
+        stream.next_out = reinterpret_cast<Bytef *>(output.data());
+        stream.avail_out = uInt(output.size());
+        REQUIRE(::inflate(&stream, Z_FINISH) == Z_STREAM_END);
+        output.resize(stream.total_out);
+        inflateEnd(&stream);
+        return output;
+    };
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    http::headers headers{{"Content-Type", "application/json"}};
+                    if (request.url() == "/json") {
+                        co_await http::async_send_encoded(session, request, http::status::ok, std::move(headers),
+                                                          as_bytes(span{json.data(), json.size()}));
+                    } else if (request.url() == "/stream" or request.url() == "/small") {
+                        size_t size = request.url() == "/stream" ? json.size() : 100;
+                        http::encoded_response response{session, request, http::status::ok, std::move(headers)};
+                        for (size_t offset = 0; offset < size; offset += 100) {
+                            auto chunk = std::string_view{json}.substr(offset, std::min<size_t>(100, size - offset));
+                            co_await net::async_send(response, as_bytes(span{chunk.data(), chunk.size()}));
+                        }
+                        co_await net::async_send(response);
+                    } else {
+                        co_await http::async_send_static_file(session, request, path);
+                    }
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            auto get = [&](std::string_view url) -> task<std::pair<std::string, std::string>> {
+                http::headers headers{{"Accept-Encoding", "gzip, deflate;q=0.5"}};
+                auto response = co_await net::async_send(client, url, http::method::get, std::move(headers));
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                REQUIRE(response.header(http::header_id::vary) == "Accept-Encoding");
+                co_return std::pair{std::string{response.header(http::header_id::content_encoding)}, std::move(body)};
+            };
+
+            auto [json_encoding, json_body] = co_await get("/json");
+            REQUIRE(json_encoding == "gzip");
+            REQUIRE(json_body.size() < json.size());
+            REQUIRE(inflate(json_body) == json);
+
+            auto [stream_encoding, stream_body] = co_await get("/stream");
+            REQUIRE(stream_encoding == "gzip");
+            REQUIRE(inflate(stream_body) == json);
+
+            auto [small_encoding, small_body] = co_await get("/small");
+            REQUIRE(small_encoding.empty());
+            REQUIRE(small_body == json.substr(0, 100));
+
+            auto [file_encoding, file_body] = co_await get("/file");
+            REQUIRE(file_encoding == "gzip");
+            REQUIRE(file_body == "precompressed");
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http request body limits", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    server.options().max_body_size = 1024;
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    size_t size = 0;
+                    while (net::has_pending_data(request)) {
+                        auto data = co_await net::async_recv(request);
+                        size += data.size();
+                    }
+                    auto body = std::to_string(size);
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{body.data(), body.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto exchange = [&](std::string_view request, bool wait_continue = false) -> task<std::string> {
+                auto sock = net::open_socket(ctx, net::tcp_client);
+                co_await net::async_connect(sock, server_endpoint);
+                auto headers_end = request.find("\r\n\r\n") + 4;
+                std::string responses;
+                std::array<char, 1024> buffer{};
+                if (wait_continue) {
+                    co_await net::async_send(sock, as_bytes(span{request.data(), headers_end}));
+                    size_t bytes = co_await net::async_recv(sock, as_writable_bytes(span{buffer}));
+                    responses.append(buffer.data(), bytes);
+                    request.remove_prefix(headers_end);
+                }
+                co_await net::async_send(sock, as_bytes(span{request.data(), request.size()}));
+                while (size_t bytes = co_await net::async_recv(sock, as_writable_bytes(span{buffer}))) {
+                    responses.append(buffer.data(), bytes);
+                }
+                co_return responses;
+            };
+
+            // rejected before the body is sent
+            auto too_large = co_await exchange(
+                "POST / HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 2000\r\n\r\n");
+            REQUIRE(too_large.starts_with("HTTP/1.1 413"));
+
+            // rejected while receiving (only sends what the server reads, so that the connection is not reset)
+            const std::string partial_body(1500, 'x');
+            auto too_large_chunked = co_await exchange(
+                fmt::format("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n7d0\r\n{}", partial_body));
+            REQUIRE(too_large_chunked.starts_with("HTTP/1.1 413"));
+
+            auto continued = co_await exchange("POST / HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 5\r\n"
+                                               "Connection: close\r\n\r\nHello",
+                                               true);
+            REQUIRE(continued.starts_with("HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200"));
+            REQUIRE(continued.ends_with("\r\n\r\n5"));
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http upload to file", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    auto path = std::filesystem::temp_directory_path() / "g6-http-upload-test.bin";
+    scope_guard remove_file = [&]() noexcept { std::filesystem::remove(path); };
+    std::string content(3 * 1024 * 1024 + 17, '\0');
+    for (size_t ii = 0; ii < content.size(); ++ii) { content[ii] = char(ii * 31 % 251); }
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    auto file = open_file_write_only(ctx.get_scheduler(), path);
+                    auto written = co_await http::async_recv_to_file(request, file);
+                    auto body = std::to_string(written);
+                    co_await net::async_send(session, http::status::created, as_bytes(span{body.data(), body.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            auto response = co_await net::async_send(client, "/upload", http::method::put,
+                                                     as_bytes(span{content.data(), content.size()}));
+            std::string body;
+            while (net::has_pending_data(response)) {
+                auto data = co_await net::async_recv(response);
+                body.append(reinterpret_cast<char const *>(data.data()), data.size());
+            }
+            REQUIRE(response.status_code() == http::status::created);
+            REQUIRE(body == std::to_string(content.size()));
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+
+    std::ifstream file{path, std::ios::binary};
+    std::string uploaded{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    REQUIRE(uploaded == content);
+}
+
+TEST_CASE("http chunked upload", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    const std::string line = "2021-03-01T12:00:00Z INFO g6 log line\n";
+    constexpr size_t line_count = 1000;
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &line]<typename Request>(Request request) -> task<void> {
+                    REQUIRE(request.chunked());
+                    std::string body;
+                    while (net::has_pending_data(request)) {
+                        auto data = co_await net::async_recv(request);
+                        body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                    }
+                    REQUIRE(body.size() == line.size() * line_count);
+                    REQUIRE(body.starts_with(line));
+                    auto size = std::to_string(body.size());
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{size.data(), size.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            for (int ii = 0; ii < 2; ++ii) {
+                http::headers headers{{"Content-Type", "text/plain"}};
+                auto stream = co_await net::async_send(client, "/ingest", http::method::post, std::move(headers),
+                                                       http::chunked);
+                for (size_t jj = 0; jj < line_count; ++jj) {
+                    co_await net::async_send(stream, as_bytes(span{line.data(), line.size()}));
+                }
+                auto response = co_await net::async_send(stream);
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                REQUIRE(response.status_code() == http::status::ok);
+                REQUIRE(body == std::to_string(line.size() * line_count));
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http client pool", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    http::client_pool_options options{};
+    options.max_per_host = 2;
+    http::client_pool pool{ctx, options};
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    if (request.url() == "/close") { session.keep_alive(false); }
+                    auto const &path = request.url();
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{path.data(), path.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto get = [&](std::string_view path) -> task<std::string> {
+                auto client = co_await net::async_connect(pool, web::proto::http, server_endpoint);
+                auto response = co_await net::async_send(*client, path, http::method::get);
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                co_return body;
+            };
+            // sequential requests share a single connection
+            for (int ii = 0; ii < 10; ++ii) { REQUIRE(co_await get("/seq") == "/seq"); }
+            REQUIRE(pool.statistics().connects == 1);
+            REQUIRE(pool.statistics().reuses == 9);
+
+            // connection closed by the server is not reused
+            REQUIRE(co_await get("/close") == "/close");
+            REQUIRE(co_await get("/after-close") == "/after-close");
+            REQUIRE(pool.statistics().connects == 2);
+
+            // concurrent requests are limited to max_per_host connections
+            auto worker = [&]() -> task<void> {
+                for (int ii = 0; ii < 10; ++ii) { REQUIRE(co_await get("/concurrent") == "/concurrent"); }
+            };
+            co_await when_all(worker(), worker(), worker());
+            REQUIRE(pool.statistics().connects <= 3);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http client pipelining", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session]<typename Request>(Request request) -> task<void> {
+                    auto const &path = request.url();
+                    co_await net::async_send(session, http::status::ok, as_bytes(span{path.data(), path.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            auto read_all = [](auto &response) -> task<std::string> {
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                co_return body;
+            };
+
+            // all requests are sent before reading responses
+            std::vector<typename decltype(client)::response> responses;
+            for (int ii = 0; ii < 8; ++ii) {
+                auto path = fmt::format("/seq/{}", ii);
+                responses.emplace_back(co_await net::async_send(client, path, http::method::get));
+            }
+            REQUIRE_FALSE(client.reusable());
+            for (int ii = 0; ii < 8; ++ii) { REQUIRE(co_await read_all(responses[ii]) == fmt::format("/seq/{}", ii)); }
+            REQUIRE(client.reusable());
+
+            // concurrent callers: responses are matched to their requests
+            auto get = [&](std::string path) -> task<void> {
+                auto response = co_await net::async_send(client, path, http::method::get);
+                REQUIRE(co_await read_all(response) == path);
+            };
+            co_await when_all(get("/a"), get("/b"), get("/c"), get("/d"));
+
+            // HEAD response has no body
+            auto head = co_await net::async_send(client, "/head", http::method::head);
+            auto get_after_head = co_await net::async_send(client, "/after-head", http::method::get);
+            REQUIRE((co_await read_all(head)).empty());
+            REQUIRE(co_await read_all(get_after_head) == "/after-head");
+            REQUIRE(client.reusable());
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http route dispatch", "[g6::net::http]") {
+    auto router = http::route::router{
+        std::make_tuple(),
+        http::route::get<R"(/api/users/(\d+))">([](std::string_view id) { return fmt::format("get user {}", id); }),
+        http::route::post<R"(/api/users)">([]() { return std::string{"create user"}; }),
+        http::route::get<R"(/)">([]() { return std::string{"index"}; }),
+        http::route::get<R"(/static/(.*))">([](std::string_view path) { return fmt::format("static {}", path); }),
+        http::route::get<R"(/(.*)\.txt)">([](std::string_view name) { return fmt::format("text {}", name); }),
+        router::on<R"(/api/(.*))">([](std::string_view path) { return fmt::format("api {}", path); })};
+
+    REQUIRE(router("/api/users/42", http::method::get) == "get user 42");
+    REQUIRE(router("/api/users", http::method::post) == "create user");
+    REQUIRE(router("/", http::method::get) == "index");
+    REQUIRE(router("/static/app.js", http::method::get) == "static app.js");
+    // routes without literal first segment are tried in declaration order
+    REQUIRE(router("/static.txt", http::method::get) == "text static");
+    REQUIRE(router("/api/users.txt", http::method::get) == "text api/users");
+    // any method
+    REQUIRE(router("/api/users", http::method::get) == "api users");
+    REQUIRE(router("/api/users/42", http::method::delete_) == "api users/42");
+    REQUIRE_THROWS_AS(router("/unknown", http::method::get), std::system_error);
+    REQUIRE_THROWS_AS(router("/", http::method::post), std::system_error);
+}
+
+TEST_CASE("http route method handling", "[g6::net::http]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::http, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    size_t handler_calls = 0;
+    using session_t = http::server_session<net::async_socket>;
+    auto router = http::route::router{
+        std::make_tuple(),
+        http::route::get<R"(/health)">([&](router::context<session_t> session) -> task<void> {
+            ++handler_calls;
+            co_await net::async_send(*session, http::status::ok, as_bytes(span{"OK !", 4}));
+        }),
+        http::route::post<R"(/health)">([&](router::context<session_t> session) -> task<void> {
+            ++handler_calls;
+            co_await net::async_send(*session, http::status::created);
+        }),
+        router::on<R"(.*)">([&](router::context<session_t> session) -> task<void> {
+            ++handler_calls;
+            co_await net::async_send(*session, http::status::not_found);
+        })};
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&session, &router]<typename Request>(Request request) -> task<void> {
+                    co_await router.async_serve(session, request);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto client = co_await net::async_connect(ctx, web::proto::http, server_endpoint);
+            auto send = [&](std::string_view path,
+                            http::method method) -> task<std::tuple<http::status, std::string, std::string, std::string>> {
+                auto response = co_await net::async_send(client, path, method, http::headers{});
+                std::string body;
+                while (net::has_pending_data(response)) {
+                    auto data = co_await net::async_recv(response);
+                    body.append(reinterpret_cast<char const *>(data.data()), data.size());
+                }
+                co_return std::tuple{response.status_code(), std::string{response.header(http::header_id::allow)},
+                                     std::string{response.header(http::header_id::content_length)}, std::move(body)};
+            };
+
+            auto [get_status, get_allow, get_length, get_body] = co_await send("/health", http::method::get);
+            REQUIRE(get_status == http::status::ok);
+            REQUIRE(get_body == "OK !");
+            REQUIRE(handler_calls == 1);
+
+            // HEAD is served by the GET route, without body
+            auto [head_status, head_allow, head_length, head_body] = co_await send("/health", http::method::head);
+            REQUIRE(head_status == http::status::ok);
+            REQUIRE(head_length == "4");
+            REQUIRE(head_body.empty());
+            REQUIRE(handler_calls == 2);
+
+            // answered from the route table
+            auto [options_status, options_allow, options_length, options_body] =
+                co_await send("/health", http::method::options);
+            REQUIRE(options_status == http::status::no_content);
+            REQUIRE(options_allow == "GET, HEAD, POST, OPTIONS");
+            auto [put_status, put_allow, put_length, put_body] = co_await send("/health", http::method::put);
+            REQUIRE(put_status == http::status::method_not_allowed);
+            REQUIRE(put_allow == "GET, HEAD, POST, OPTIONS");
+            REQUIRE(handler_calls == 2);
+
+            // unknown path falls back to the any-method route
+            auto [missing_status, missing_allow, missing_length, missing_body] =
+                co_await send("/missing", http::method::put);
+            REQUIRE(missing_status == http::status::not_found);
+            REQUIRE(handler_calls == 3);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("http request uri", "[g6::net::http]") {
+    web::uri uri{"https://example.com:8443/search/my%20file?q=hello+world&page=2&&flag=true&ratio=0.5&empty#top"};
+    REQUIRE(uri.scheme() == "https");
+    REQUIRE(uri.host() == "example.com");
+    REQUIRE(uri.port() == "8443");
+    REQUIRE(uri.path() == "/search/my%20file");
+    REQUIRE(uri.query() == "q=hello+world&page=2&&flag=true&ratio=0.5&empty");
+    REQUIRE(uri.fragment() == "top");
+    REQUIRE(uri.uses_ssl());
+
+    std::vector<std::string_view> names;
+    for (auto const &parameter : uri.query_parameters()) { names.push_back(parameter.name); }
+    REQUIRE(names == std::vector<std::string_view>{"q", "page", "flag", "ratio", "empty"});
+
+    REQUIRE(uri.get("q") == "hello+world");
+    REQUIRE(uri.get<std::string>("q") == "hello world");
+    REQUIRE(uri.get<int>("page") == 2);
+    REQUIRE(uri.get<bool>("flag") == true);
+    REQUIRE(uri.get<double>("ratio") == 0.5);
+    REQUIRE(uri.get("empty") == "");
+    REQUIRE_FALSE(uri.get<int>("q"));
+    REQUIRE_FALSE(uri.get("missing"));
+
+    web::uri origin{"/index.html?a=%31"};
+    REQUIRE(origin.scheme().empty());
+    REQUIRE(origin.host().empty());
+    REQUIRE(origin.path() == "/index.html");
+    REQUIRE(origin.get<int>("a") == 1);
+}
+
+TEST_CASE("http uri escaping", "[g6::net::http]") {
+    // long enough for the vectorized paths, with a tail for the scalar one
+    const std::string input = "caf\xc3\xa9 cr\xc3\xa8me/AND price<=20 OR tag:\"g6/web\"&lang=fr+en_0123456789abcdefXYZ";
+    const auto escaped = web::uri::escape(input);
+    REQUIRE(escaped.starts_with("caf%C3%A9%20cr%C3%A8me%2FAND%20price%3C%3D20"));
+    REQUIRE(escaped.find_first_not_of("%ABCDEFabcdefghijklmnopqrstuvwxyzGHIJKLMNOPQRSTUVWXYZ0123456789")
+            == std::string::npos);
+    REQUIRE(web::uri::unescape(escaped) == input);
+
+    REQUIRE(web::uri::unescape("a+b%2Bc") == "a+b+c");
+    REQUIRE(web::uri::unescape("a+b%2Bc", true) == "a b+c");
+    // malformed escapes are kept
+    REQUIRE(web::uri::unescape("100%") == "100%");
+    REQUIRE(web::uri::unescape("%zz%4") == "%zz%4");
+
+    std::string output = "prefix:";
+    web::uri::unescape("%41%42", output);
+    REQUIRE(output == "prefix:AB");
+}
@@ -4,12 +4,21 @@
 #include <g6/io/context.hpp>
 
 #include <g6/ws/client.hpp>
+#include <g6/ws/deflate.hpp>
+#include <g6/ws/hub.hpp>
+#include <g6/ws/mask.hpp>
 #include <g6/ws/server.hpp>
 
 #include <unifex/sync_wait.hpp>
 #include <unifex/task.hpp>
 #include <unifex/when_all.hpp>
 
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
 using namespace g6;
 
 TEST_CASE("ws simple server", "[g6::net::ws]") {
@@ -56,3 +65,475 @@ TEST_CASE("ws simple server", "[g6::net::ws]") {
             co_return;
         }()));
 }
+
+TEST_CASE("ws masking", "[g6::net::ws]") {
+    const uint32_t masking_key = 0x12345678;
+    std::byte key[4];
+    std::memcpy(key, &masking_key, 4);
+
+    std::vector<std::byte> payload(203);
+    for (size_t ii = 0; ii < payload.size(); ++ii) { payload[ii] = std::byte(ii * 7); }
+    std::vector<std::byte> expected(payload.size());
+    for (size_t ii = 0; ii < payload.size(); ++ii) { expected[ii] = payload[ii] ^ key[ii % 4]; }
+
+    // unaligned input and output
+    std::vector<std::byte> masked(payload.size() + 1);
+    auto input = as_bytes(span{payload.data() + 1, payload.size() - 1});
+    REQUIRE(ws::apply_mask(input, span{masked.data() + 1, input.size()}, masking_key, 1) == payload.size() % 4);
+    REQUIRE(std::memcmp(masked.data() + 1, expected.data() + 1, payload.size() - 1) == 0);
+
+    // in place, in parts
+    size_t key_offset = 0;
+    for (size_t offset = 0, size = 1; offset < payload.size(); offset += size, size = size * 3 + 1) {
+        size = std::min(size, payload.size() - offset);
+        key_offset = ws::apply_mask(span{payload.data() + offset, size}, masking_key, key_offset);
+    }
+    REQUIRE(payload == expected);
+}
+
+TEST_CASE("ws large messages", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    auto read_message = [](auto &message) -> task<std::string> {
+        std::string body;
+        while (net::has_pending_data(message)) {
+            auto data = co_await net::async_recv(message);
+            body.append(reinterpret_cast<const char *>(data.data()), data.size());
+        }
+        co_return body;
+    };
+
+    // larger than the receive buffer, then small messages likely received together
+    std::vector<std::string> messages{std::string(200 * 1024, 'x'), "a", "", "b"};
+    for (size_t ii = 0; ii < messages[0].size(); ++ii) { messages[0][ii] = char('a' + ii % 26); }
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    // echo
+                    co_await net::async_send(session, as_bytes(span{co_await read_message(request)}));
+                    for (size_t ii = 1; ii < messages.size(); ++ii) {
+                        auto next = co_await net::async_recv(session);
+                        auto body = co_await read_message(next);
+                        co_await net::async_send(session, as_bytes(span{body.data(), body.size()}));
+                    }
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            for (auto const &message : messages) {
+                co_await net::async_send(session, as_bytes(span{message.data(), message.size()}));
+            }
+            for (auto const &message : messages) {
+                auto response = co_await net::async_recv(session);
+                REQUIRE(co_await read_message(response) == message);
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws in-place send", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    const std::string message(100 * 1024, 'z');
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    std::string body;
+                    while (net::has_pending_data(request)) {
+                        auto data = co_await net::async_recv(request);
+                        body.append(reinterpret_cast<const char *>(data.data()), data.size());
+                    }
+                    REQUIRE(body == message);
+                    co_await ws::async_send_in_place(session, as_writable_bytes(span{body.data(), body.size()}));
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            std::string payload = message;
+            co_await ws::async_send_in_place(session, as_writable_bytes(span{payload.data(), payload.size()}));
+            auto response = co_await net::async_recv(session);
+            std::string body;
+            while (net::has_pending_data(response)) {
+                auto data = co_await net::async_recv(response);
+                body.append(reinterpret_cast<const char *>(data.data()), data.size());
+            }
+            REQUIRE(body == message);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws hub", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    using hub_type = ws::hub<ws::server_session<net::async_socket>>;
+    hub_type hub{};
+
+    auto read_message = [](auto &message) -> task<std::string> {
+        std::string body;
+        while (net::has_pending_data(message)) {
+            auto data = co_await net::async_recv(message);
+            body.append(reinterpret_cast<const char *>(data.data()), data.size());
+        }
+        co_return body;
+    };
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    hub_type::subscriber subscriber{hub, session};
+                    subscriber.join("room");
+                    co_await when_all(subscriber.async_run(), [&]() -> task<void> {
+                        scope_guard _ = [&]() noexcept { subscriber.close(); };
+                        // first message joins
+                        co_await read_message(request);
+                        std::string_view joined = "joined";
+                        subscriber.send(as_bytes(span{joined.data(), joined.size()}));
+                        try {
+                            while (true) {
+                                auto message = co_await net::async_recv(session);
+                                auto body = co_await read_message(message);
+                                hub.publish("room", as_bytes(span{body.data(), body.size()}), &subscriber);
+                            }
+                        } catch (std::system_error const &) {}
+                    }());
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto alice = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            auto bob = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            for (auto *session : {&alice, &bob}) {
+                co_await net::async_send(*session, as_bytes(span{"join", 4}));
+                auto response = co_await net::async_recv(*session);
+                REQUIRE(co_await read_message(response) == "joined");
+            }
+            REQUIRE(hub.size() == 2);
+            co_await net::async_send(alice, as_bytes(span{"hello bob", 9}));
+            auto to_bob = co_await net::async_recv(bob);
+            REQUIRE(co_await read_message(to_bob) == "hello bob");
+            co_await net::async_send(bob, as_bytes(span{"hello alice", 11}));
+            auto to_alice = co_await net::async_recv(alice);
+            REQUIRE(co_await read_message(to_alice) == "hello alice");
+            REQUIRE(hub.statistics().published == 2);
+            REQUIRE(hub.statistics().dropped == 0);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws deflate negotiation", "[g6::net::ws]") {
+    ws::deflate_options server_options{.enabled = true, .server_max_window_bits = 12};
+    // first acceptable offer
+    auto params = ws::negotiate_deflate(
+        server_options, "permessage-deflate; unknown, permessage-deflate; client_max_window_bits; server_no_context_takeover");
+    REQUIRE(params);
+    REQUIRE(params->server_no_context_takeover);
+    REQUIRE(params->server_max_window_bits == 12);
+    REQUIRE(params->to_string() == "permessage-deflate; server_no_context_takeover; server_max_window_bits=12");
+    REQUIRE_FALSE(ws::negotiate_deflate(ws::deflate_options{}, "permessage-deflate"));
+    REQUIRE_FALSE(ws::negotiate_deflate(server_options, "x-webkit-deflate-frame"));
+
+    // memory cap: windows are narrowed, the client one can only be when it offered client_max_window_bits
+    ws::deflate_options capped{.enabled = true, .max_memory = 160 * 1024};
+    params = ws::negotiate_deflate(capped, "permessage-deflate; client_max_window_bits");
+    REQUIRE(params);
+    REQUIRE(params->client_max_window_bits < 15);
+    REQUIRE_FALSE(ws::negotiate_deflate(capped, "permessage-deflate"));
+
+    ws::deflate_options client_options{.enabled = true, .client_no_context_takeover = true};
+    REQUIRE(ws::deflate_offer(client_options) == "permessage-deflate; client_no_context_takeover; client_max_window_bits");
+    auto accepted = ws::accept_deflate(client_options, "permessage-deflate; server_max_window_bits=10");
+    REQUIRE(accepted);
+    REQUIRE(accepted->client_no_context_takeover);
+    REQUIRE(accepted->server_max_window_bits == 10);
+    REQUIRE_FALSE(ws::accept_deflate(client_options, ""));
+    REQUIRE_THROWS_AS(ws::accept_deflate(client_options, "permessage-deflate; foo"), std::system_error);
+}
+
+TEST_CASE("ws permessage-deflate", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    server.upgrade_options().deflate.enabled = true;
+
+    auto read_message = [](auto &message) -> task<std::string> {
+        std::string body;
+        while (net::has_pending_data(message)) {
+            auto data = co_await net::async_recv(message);
+            body.append(reinterpret_cast<const char *>(data.data()), data.size());
+        }
+        co_return body;
+    };
+
+    std::string json{"["};
+    for (int ii = 0; ii < 2000; ++ii) {
+        json += R"({"id":)" + std::to_string(ii) + R"(,"symbol":"G6","price":12.5,"quantity":100},)";
+    }
+    json.back() = ']';
+    std::vector<std::string> messages{json, "small", "", json};
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    REQUIRE(session.deflate());
+                    REQUIRE(request.compressed());
+                    co_await net::async_send(session, as_bytes(span{co_await read_message(request)}));
+                    for (size_t ii = 1; ii < messages.size(); ++ii) {
+                        auto next = co_await net::async_recv(session);
+                        auto body = co_await read_message(next);
+                        co_await net::async_send(session, as_bytes(span{body.data(), body.size()}));
+                    }
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            ws::connection_options options{};
+            options.deflate = {.enabled = true, .client_no_context_takeover = true};
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint, options);
+            REQUIRE(session.deflate());
+            REQUIRE(session.deflate()->client_no_context_takeover);
+            for (auto const &message : messages) {
+                co_await net::async_send(session, as_bytes(span{message.data(), message.size()}));
+            }
+            for (auto const &message : messages) {
+                auto response = co_await net::async_recv(session);
+                REQUIRE(response.compressed() == (message.size() >= options.deflate.min_size));
+                REQUIRE(co_await read_message(response) == message);
+            }
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws fragmented compressed message", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    server.upgrade_options().deflate.enabled = true;
+
+    std::string json{"["};
+    for (int ii = 0; ii < 2000; ++ii) { json += R"({"id":)" + std::to_string(ii) + R"(,"symbol":"G6"},)"; }
+    json.back() = ']';
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    while (net::has_pending_data(request)) { co_await net::async_recv(request); }
+                    // compressed message split in two frames (rsv1 on the first one only)
+                    ws::deflate_codec codec{*session.deflate(), true, Z_DEFAULT_COMPRESSION};
+                    auto compressed = codec.compress(as_bytes(span{json.data(), json.size()}));
+                    std::vector<std::byte> payload{compressed.begin(), compressed.end()};
+                    codec.end_compress();
+                    const size_t split = payload.size() / 2;
+                    std::vector<std::byte> frames;
+                    auto append_frame = [&](ws::header h, span<std::byte const> data) {
+                        std::array<std::byte, ws::header::max_header_size> header_data{};
+                        h.serialize(header_data);
+                        frames.insert(frames.end(), header_data.begin(), header_data.begin() + h.payload_offset);
+                        frames.insert(frames.end(), data.begin(), data.end());
+                    };
+                    append_frame({.fin = false, .rsv1 = true, .opcode = ws::op_code::text_frame, .payload_length = split},
+                                 span{payload.data(), split});
+                    append_frame({.fin = true, .opcode = ws::op_code::continuation_frame,
+                                  .payload_length = payload.size() - split},
+                                 span{payload.data() + split, payload.size() - split});
+                    co_await ws::async_send_frame(session, span{frames.data(), frames.size()});
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            ws::connection_options options{};
+            options.deflate.enabled = true;
+            // the decompressed size alone is checked against the limit
+            options.max_message_size = json.size();
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint, options);
+            co_await net::async_send(session, as_bytes(span{"go", 2}));
+            auto response = co_await net::async_recv(session);
+            REQUIRE(response.compressed());
+            std::string body;
+            while (net::has_pending_data(response)) {
+                auto data = co_await net::async_recv(response);
+                body.append(reinterpret_cast<const char *>(data.data()), data.size());
+            }
+            REQUIRE(body == json);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws control frames", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    const std::vector<std::byte> message{std::byte{0x00}, std::byte{0xff}, std::byte{0x80}, std::byte{0x7f}};
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    REQUIRE(request.opcode() == ws::op_code::binary_frame);
+                    std::vector<std::byte> body;
+                    while (net::has_pending_data(request)) {
+                        auto data = co_await net::async_recv(request);
+                        body.insert(body.end(), data.begin(), data.end());
+                    }
+                    REQUIRE(body == message);
+                    co_await net::async_send(session, as_bytes(span{body.data(), body.size()}), ws::op_code::binary_frame);
+                    co_await ws::async_close(session, ws::status_code::going_away, "bye");
+                    REQUIRE(session.close_status() == ws::status_code::going_away);
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            // the pong is handled while receiving the response
+            co_await ws::async_ping(session, as_bytes(span{"ping", 4}));
+            co_await net::async_send(session, span{message.data(), message.size()}, ws::op_code::binary_frame);
+            auto response = co_await net::async_recv(session);
+            REQUIRE(response.opcode() == ws::op_code::binary_frame);
+            std::vector<std::byte> body;
+            while (net::has_pending_data(response)) {
+                auto data = co_await net::async_recv(response);
+                body.insert(body.end(), data.begin(), data.end());
+            }
+            REQUIRE(body == message);
+            // the close frame is echoed and ends the connection
+            bool closed = false;
+            try {
+                co_await net::async_recv(session);
+            } catch (std::system_error const &error) { closed = error.code() == std::errc::connection_reset; }
+            REQUIRE(closed);
+            REQUIRE(session.close_status() == ws::status_code::going_away);
+            // nothing can be sent once closed
+            bool sent = true;
+            try {
+                co_await net::async_send(session, span{message.data(), message.size()}, ws::op_code::binary_frame);
+            } catch (std::system_error const &) { sent = false; }
+            REQUIRE_FALSE(sent);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws invalid close frame", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+
+    std::error_code server_error{};
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    try {
+                        while (true) { co_await net::async_recv(session); }
+                    } catch (std::system_error const &error) { server_error = error.code(); }
+                    REQUIRE(not session.close_status());
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            co_await net::async_send(session, as_bytes(span{"hello", 5}));
+            // 1005 must not be sent in a close frame: the server fails the connection with 1002
+            co_await ws::async_close(session, ws::status_code::no_status_code);
+            REQUIRE(session.close_status() == ws::status_code::protocol_error);
+            auto sched = ctx.get_scheduler();
+            co_await schedule_at(sched, now(sched) + std::chrono::milliseconds{50});
+            REQUIRE(server_error == std::errc::protocol_error);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}
+
+TEST_CASE("ws keepalive", "[g6::net::ws]") {
+    io::context ctx{};
+    inplace_stop_source stop_source{};
+
+    auto server = web::make_server(ctx, web::proto::ws, *net::ip_endpoint::from_string("127.0.0.1:0"));
+    auto server_endpoint = *server.socket.local_endpoint();
+    // keepalive is opt-in
+    REQUIRE(server.upgrade_options().ping_interval.count() == 0);
+    server.upgrade_options().ping_interval = std::chrono::milliseconds{50};
+    server.upgrade_options().pong_timeout = std::chrono::milliseconds{50};
+
+    bool disconnected = false;
+
+    sync_wait(when_all(
+        [&]() -> task<void> {
+            co_await web::async_serve(server, stop_source, [&]<typename Session>(Session &session) {
+                return [&]<typename Request>(Request request) -> task<void> {
+                    try {
+                        while (true) { co_await net::async_recv(session); }
+                    } catch (std::system_error const &) { disconnected = true; }
+                };
+            });
+        }(),
+        [&]() -> task<void> {
+            scope_guard _ = [&]() noexcept { stop_source.request_stop(); };
+            auto session = co_await net::async_connect(ctx, web::proto::ws, server_endpoint);
+            co_await net::async_send(session, as_bytes(span{"hello", 5}));
+            // pings are not answered: the client does not receive
+            auto sched = ctx.get_scheduler();
+            co_await schedule_at(sched, now(sched) + std::chrono::milliseconds{500});
+            REQUIRE(disconnected);
+        }(),
+        [&]() -> task<void> {
+            ctx.run(stop_source.get_token());
+            co_return;
+        }()));
+}